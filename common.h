@@ -4,10 +4,39 @@ This module defines the main data structure in the program, the list of
 individuals and their characteristics, also the main space-consuming entity in
 the program.
 
+Each individual's record is held in two parts, in parallel lists indexed by the
+same number. The main part, in 'A', holds what nearly every event and every
+census needs: the state, the pending event, sex, region of birth, and the times
+of birth, death, and emigration. The supplementary part, in 'Ac', holds the
+other times, which are needed only by infected and diseased individuals. A scan
+of the whole population for a census thus passes over less than half the
+memory, and an event for an uninfected individual touches only the main part.
+A field is reached by its name through the list holding it, 'A[n].tDeath' or
+'Ac[n].tExit', and a misplaced one is caught when compiling.
+
 Time is encoded in 8-byte double-precision floating point values ('dec'), which
 is simple but a little extravagant. At the cost of a clarity time could be
 encoded in 4-byte unsigned integers instead, with a single floating point number
 defining the base year and time.
+
+That is done when 'COMPACT' is defined. The times in each record are then held
+as 4-byte 'ticks' of 2^-24 year (about two seconds) counted from the year 'TB',
+which spans the years 1850 to 2106, and the five small fields are packed into a
+single 2-byte word, halving the size of each record. Times are always read from
+a record through 'TGET' and written through 'TPUT', or 'TPUTB' for the time of
+birth, which convert them to and from years; without 'COMPACT' these do nothing.
+Times are rounded up when stored, so an event read back from a record is never
+in the past, except the time of birth, which is rounded down so that an age is
+never understated. Times beyond the span are held at its ends. Results then
+differ from those with full times only by the rounding.
+
+The times of mutation and of transmission are drawn from exponential
+distributions, whose rates change only with the state, so a time drawn afresh
+whenever it is needed serves as well as one drawn earlier and kept. When
+'REDRAW' is defined they are not kept in the record; only whether a diseased
+individual transmits at all is kept, in 'spos'. The supplementary part is then
+smaller by two times. Results differ from those with the times kept only by the
+particular random numbers drawn, which the program in 'redraw.c' checks.
 */
 
 #ifndef TYPEDEF
@@ -23,9 +52,8 @@ typedef unsigned char charu;
 #include <math.h>
 #include <time.h>
 
-//#define indiv 20000000    //Maximum population size.
-#define indiv 75000000  //Maximum population size.
-#define INDIV indiv       //Maximum population size.
+extern int indiv;         //Maximum population size, set when the program
+                          //starts.
 
 // FUTURE TIMES:
 #define iBirth        0   //Time of initiation of this record
@@ -36,31 +64,84 @@ typedef unsigned char charu;
 #define iMutate       5   //Time of strain type mutation
 #define iEmigrate     6   //Time of emigration
 #define iRep          7   //Time to report disease case
-#define tBirth      t[0]  //Time of initiation of this record
-#define tExit       t[1]  //Time for exit from this state
-#define tDeath      t[2]  //Time for closure of this record
-#define tDisease    t[3]  //Time of progression to disease
-#define tTransm     t[4]  //Time to transmit infection to another
-#define tMutate     t[5]  //Time of strain type mutation
-#define tEmigrate   t[6]  //Time of emigration
-#define tRep        t[7]  //Time to report disease case
+#define tBirth      t[0]  //Time of initiation of this record        (A)
+#define tDeath      t[1]  //Time for closure of this record          (A)
+#define tEmigrate   t[2]  //Time of emigration                       (A)
+#define tExit       u[0]  //Time for exit from this state            (Ac)
+#define tDisease    u[1]  //Time of progression to disease           (Ac)
+#ifdef REDRAW
+#define tRep        u[2]  //Time to report disease case              (Ac)
+#else
+#define tTransm     u[2]  //Time to transmit infection to another    (Ac)
+#define tMutate     u[3]  //Time of strain type mutation             (Ac)
+#define tRep        u[4]  //Time to report disease case              (Ac)
+#endif
 
 //#define tImm      t[0]  //Time of immigration to UK
 //#define tInfected t[0]  //Time individual was most recently infected
 //#define strain    t[0]  //Strain type identification number
 
-struct Indiv           //STRUCTURE OF EACH RECORD                   BYTES
+//#define COMPACT      //Hold records in half the space (see above).
+//#define REDRAW       //Draw times of mutation and transmission as needed.
+
+#ifdef COMPACT
+typedef unsigned int tick;          //Time within a record, in ticks after 'TB'.
+#define TB       1850.              //Year from which ticks are counted.
+#define TU       (1./16777216)      //Years per tick, 2^-24.
+#define TGET(x)  (TB+(x)*TU)        //Time in a record, in years.
+#define TPUT(y)  Tick(y,1)          //Years to a time in a record, rounded up,
+#define TPUTB(y) Tick(y,0)          //or rounded down for the time of birth.
+#else
+typedef dec tick;                   //Time within a record, in years.
+#define TGET(x)  (x)
+#define TPUT(y)  (y)
+#define TPUTB(y) (y)
+#endif
+
+#ifdef COMPACT
+struct Indiv           //STRUCTURE OF EACH RECORD, MAIN PART (COMPACT) BYTES
 {
-  dec  t[8];           //Separate times for individual               64
+  tick t[3];           //Times of birth, death, and emigration       12
+  unsigned short
+    pending:4,         //Number of pending event                      *
+    state:4,           //Number of present state                      *
+    sex:1,             //Sex of this individual (0=female, 1=male)    *
+    rob:1,             //Region of birth (0=Foreign-born, 1=UK-born)  *
+    ssa:2,             //0=UK & non-UK other(HIV-), 1=SSA (HIV-) 2=SSA (HIV+) *
+    lazy:1;            //Change of state deferred (if 'plazy')        2
+#ifdef REDRAW
+  unsigned short
+    spos:1;            //Transmits while diseased (if 'REDRAW')       *
+#endif
+};                     //                                            14 *
+#else
+struct Indiv           //STRUCTURE OF EACH RECORD, MAIN PART        BYTES
+{
+  dec  t[3];           //Times of birth, death, and emigration       24
   charu pending;       //Number of pending event                      1
   charu state;         //Number of present state                      1
   char sex;            //Sex of this individual (0=female, 1=male)    1
   char rob;            //Region of birth (0=Foreign-born, 1=UK-born)  1
   //char inf;          //Region infection acquired (0=abroad, 1=UK)   1
   char ssa;            //0=UK & non-UK other(HIV-), 1=SSA (HIV-) 2=SSA (HIV+) 1
-};                     //                                            69 *
+  char lazy;           //Change of state deferred (if 'plazy')        1
+#ifdef REDRAW
+  char spos;           //Transmits while diseased (if 'REDRAW')       1
+#endif
+};                     //                                            30 *
+#endif
 
-extern struct Indiv *A;   //List of individuals.
+struct Indivc          //STRUCTURE OF EACH RECORD, SUPPLEMENTARY PART BYTES
+{
+#ifdef REDRAW
+  tick u[3];           //Times of exit, disease, and report          24
+#else                  //(12 if 'COMPACT')
+  tick u[5];           //Times of exit, disease, transmission,       40
+#endif                 //mutation, and report (20 if 'COMPACT')
+};
+
+extern struct Indiv  *A;  //List of individuals, main part.
+extern struct Indivc *Ac; //List of individuals, supplementary part.
 
 // STATES:
 #define qU         1   //Uninfected
@@ -93,6 +174,7 @@ extern struct Indiv *A;   //List of individuals.
 dec Rand();                                    //Random number generator
 dec Uniform(dec, dec);                         //Uniform random number
 dec Expon(dec);                                //Poisson events in time
+int Poisson(dec);                              //Poisson events in an interval
 dec Cauchy(dec, dec);                          //Cauchy distribution
 dec Gauss(dec, dec);                           //Gaussian distribution
 dec LogNormal(dec, dec);                       //Lognormal distribution
@@ -113,12 +195,21 @@ int Error1(dec, char*,dec);
 int Error2(dec, char*,dec, char*,dec);
 int Error3(dec, char*,dec, char*,dec, char*,dec);
 int StrainNum(int);
+void *Space(void*, int, size_t, size_t);        //Memory for individuals
+#ifdef COMPACT
+tick Tick(dec, int);
+#endif
 
 // LOCAL FUNCTIONS:
 #define min(a,b) ((a)<(b)? (a):(b))            //Minimum
 #define max(a,b) ((a)>(b)? (a):(b))            //Maximum
 #define abs(a)   ((a)>=0?  (a):-(a))           //Absolute value
 #define round(a) ((a)>=0?  (a)+0.5: (a)-0.5)   //Rounding to integer
+#ifdef __GNUC__
+#define prefetch(a) __builtin_prefetch(a)      //Request data ahead of use
+#else
+#define prefetch(a)
+#endif
 
 // Clarence Lehman, August 2009, modified by Adrienne Keen, 2010
 
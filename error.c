@@ -32,6 +32,7 @@ static char *message[] =
   "F516%s  A file I/O dimension is not positive",
   "F517%s  A file I/O index is too large",
   "F518%s  A file I/O index range is not divisible by the increment",
+  "F519%s  The file cannot be mapped into memory",
   "F520%s  The file I/O transformation does not begin with 'x' or 'n'",
   "F521%s  The file I/0 transformation would divide by zero",
   "F522%s  The file I/0 transformation is syntactically incorrect",
@@ -58,6 +59,8 @@ static char *message[] =
   "E620%s  Time to disease is in error",
   "E621%s  A cumulative table is not monotonically increasing",
   "E622%s  A cumulative table is not bounded by 0 and 1",
+  "E623%s  The lists of individuals in a state do not hold all of them",
+  "E624%s  A deferred change of state is missing",
 
   "E714%s  The kernel designator is incorrect",
   "E734%s  The event number is out of range",
@@ -65,6 +68,12 @@ static char *message[] =
   "E736%s  An event to be cancelled is not yet scheduled",
   "E737%s  A new event would be scheduled in the past",
   "E742%s  Attempt to initialize when the time bins are not empty",
+  "E743%s  The kind of event queue is not recognized",
+  "E744%s  A replayed event differs from the trace",
+  "E745%s  A renumbering of events does not use each number once",
+  "E746%s  A concurrent run differs from the serial reference",
+  "E747%s  A new event would be scheduled within the epoch under way",
+  "E748%s  Runs with and without 'REDRAW' differ beyond the limit",
   "E753%s  A binary search table is invalid",
   "E754%s  A cumulative table has gone beyond 1",
 
@@ -0,0 +1,159 @@
+/*----------------------------------------------------------------------------*
+SCHEDULER BENCHMARK
+
+This program exercises the event scheduler in 'schedule.c' by itself, without
+the rest of the model, so that changes to the scheduler can be timed on a
+population of any size. It imitates the pattern of scheduling in the
+tuberculosis model: each individual has one pending event, the earliest event
+is dispatched and the individual's next event scheduled, deaths free the
+highest-numbered index and move that individual down into the vacated one, and
+infections change the pending event of some other individual chosen at random.
+
+The same stream of events is run in two ways. The first pass uses only
+'EventCancel' and 'EventSchedule', as the model did originally, renumbering an
+individual by cancelling and scheduling it again and changing the time of an
+infected individual's event the same way. The second pass uses
+'EventRenumber' and 'EventReschedule', which do each in one operation. The
+random number sequence is restarted for each pass, so both dispatch exactly the
+same events and finish at exactly the same time. The two passes are repeated
+alternately and the best time of each is kept, since timings on a shared machine
+can vary by a good deal from run to run.
+
+Both passes are run on each kind of event queue selectable through 'EventType'
+in turn---the calendar queue, the four-way heap, the ladder queue, and the
+timing wheel---or on only one of them if it is named on the command line.
+
+The program is built with 'makeqb' and run as
+
+    qbench [n] [m] [r] [q]
+
+where 'n' is the number of individuals (default 50 million), 'm' is the number
+of events to dispatch in each pass (default 20 million), 'r' is the number of
+times each pass is repeated (default 3), and 'q' is the kind of queue, 0 through
+3, as for 'EventType' (default all). Memory needed is
+about 24 bytes per individual for the scheduler plus 8 for this program, so the
+default requires about 1.6 gigabytes, more for the other kinds of queue.
+*/
+
+#include "common.h"
+
+#define QB_N  50000000     //Default number of individuals.
+#define QB_M  20000000     //Default number of events dispatched per pass.
+#define QB_R  3            //Default number of repetitions.
+#define QB_T0 1981.        //Starting time.
+#define QB_PD 0.2          //Portion of events which are deaths.
+#define QB_PI 0.5          //Infections per event dispatched.
+#define QB_L  30.          //Mean time between an individual's events.
+#define QB_LI 2.           //Mean time to the event after an infection.
+
+extern dec t;              //Current time, from the scheduler.
+
+static dec *W;             //Time of the pending event for each individual.
+static int qn;             //Number of individuals.
+
+static dec Interval(dec);
+static dec Pass(long, int, int);
+
+static char *qname[] =     //Names of the kinds of queue.
+{ "Calendar", "Four-way heap", "Ladder", "Timing wheel" };
+
+main(int argc, char *argv[])
+{ long m; int r, q, k, i; dec s, s0[4], s1[4];
+
+  qn = argc>1? atoi(argv[1]): QB_N;          //Collect the size of the run.
+  m  = argc>2? atol(argv[2]): QB_M;
+  r  = argc>3? atoi(argv[3]): QB_R;
+  q  = argc>4? atoi(argv[4]): -1;
+  if(qn<2||m<1||r<1||q<-1||q>3)
+    Error3(525., "n=",qn, " m=",m, " r=",r);
+
+  W = (dec*)calloc(qn+1, sizeof(dec));       //Allocate the list of times.
+  if(W==0) Error(911.);
+
+  printf("%d individuals, %ld events per pass.\n", qn, m);
+
+  for(k=0; k<4; k++) s0[k] = s1[k] = 1e30;
+  for(i=0; i<r; i++)                         //Run the stream on each kind of
+  for(k=0; k<4; k++)                         //queue with cancel and schedule
+  { if(q>=0 && k!=q) continue;               //pairs, then with the combined
+    s = Pass(m, 0, k); if(s0[k]>s) s0[k] = s;//operations, keeping the best
+    s = Pass(m, 1, k); if(s1[k]>s) s1[k] = s; }//time of each.
+
+  for(k=0; k<4; k++)                         //Summarize the best times.
+    if(q<0 || k==q)
+      printf("%-14s best %.3f s and %.3f s, speedup %.2f\n",
+        qname[k], s0[k], s1[k], s0[k]/s1[k]);
+  free(W);
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+RUN ONE PASS
+
+ENTRY: 'm' contains the number of events to dispatch.
+       'mode' is zero to renumber and reschedule with 'EventCancel' and
+         'EventSchedule', or one to use 'EventRenumber' and 'EventReschedule'.
+       'type' contains the kind of event queue, as for 'EventType'.
+
+EXIT:  'Pass' contains the processor time used, in seconds, not counting the
+         construction of the initial queue.
+       A line summarizing the pass has been displayed.
+*/
+
+static dec Pass(long m, int mode, int type)
+{ long k; int i, j; dec te; clock_t c;
+
+  EventInit(); EventSize(qn);                //Start the queue and the random
+  EventType(type); RandStart(12345);         //numbers afresh.
+  EventStartTime(QB_T0);
+
+  for(i=1; i<=qn; i++)                       //Schedule one event for each
+  { W[i] = QB_T0+Interval(QB_L);             //individual.
+    EventSchedule(i, W[i]); }
+
+  c = clock();
+  for(k=0; k<m; k++)
+  { j = EventNext(); if(j==0) break;         //Dispatch the next event.
+
+    if(Rand()<QB_PD && j!=qn)                //If it is a death, move the
+    { if(mode) EventRenumber(j, qn);         //highest-numbered individual into
+      else { EventCancel(qn);                //the vacated index, then refill
+             EventSchedule(j, W[qn]); }      //the highest index with a birth.
+      W[j] = W[qn]; j = qn; }
+
+    W[j] = t+Interval(QB_L);                 //Schedule the individual's next
+    EventSchedule(j, W[j]);                  //event.
+
+    if(Rand()<QB_PI)                         //Infect someone chosen at random,
+    { i  = 1+(int)(Rand()*qn);               //changing the time of their
+      te = t+Interval(QB_LI);                //pending event.
+      if(te<W[i])
+      { if(mode) EventReschedule(i, te);
+        else { EventCancel(i); EventSchedule(i, te); }
+        W[i] = te; } } }
+
+  te = (dec)(clock()-c)/CLOCKS_PER_SEC;      //Display the results.
+  printf("%-14s %-22s %10ld events %8.3f s %10.0f per second, t=%.6f\n",
+    qname[type], mode? "Renumber/Reschedule:": "Cancel/Schedule pairs:",
+    k, te, k/te, t);
+  return te;
+}
+
+
+/*----------------------------------------------------------------------------*
+RANDOM INTERVAL
+
+ENTRY: 'mean' contains the mean interval.
+
+EXIT:  'Interval' contains an exponentially distributed interval.
+*/
+
+static dec Interval(dec mean)
+{ dec r;
+
+  do r = Rand(); while(r==0);
+  return -log(r)*mean;
+}
+
+/* October 2026 [AGT]. */
@@ -0,0 +1,443 @@
+/*----------------------------------------------------------------------------*
+CONCURRENT EVENT SCHEDULING
+
+This module is a variant of the calendar queue in 'schedule.c' into which
+several threads may schedule and cancel events at the same time, and from which
+they may take events to dispatch at the same time. It is meant for a model whose
+events are handled by several worker threads in epochs of simulated time, each
+epoch no longer than the least time between an event and any event it schedules
+(the "lookahead"). Within an epoch the events cannot affect one another, so they
+may be dispatched in any order and by any thread; between epochs all threads
+wait for one another.
+
+Three things make the queue safe to share without a lock around the whole of it.
+
+1. Scheduling touches nothing shared but the event's own stamp. Each thread
+   adds the events it schedules to a buffer of its own, and the buffers are
+   merged into the bins later, either by each thread with 'ConcMerge' whenever
+   it likes, or at the latest by 'ConcEpoch' at the start of the next epoch.
+   Every event scheduled during an epoch must fall no earlier than its end,
+   which is what the lookahead assures, so it is never needed before then.
+
+2. Each bin has a lock of its own, held only while events are added to the bin
+   or taken out of it. Threads merging or dispatching at the same time rarely
+   want the same bin, and a thread that does waits only for that bin. The lock
+   is a single word, taken with an atomic exchange; a thread that finds it
+   taken yields the processor until it is free, so that a thread holding it is
+   not kept waiting, even when there are more threads than processors.
+
+3. Cancelling takes no lock at all. Each event number has a stamp 'G[n]', which
+   is odd while the event is scheduled and even while it is not, and which is
+   advanced by one each time the event is scheduled, cancelled, or dispatched.
+   Every event in a buffer or bin carries the stamp it was scheduled with. To
+   cancel an event, a thread advances its stamp with an atomic compare and
+   exchange; the event left behind in the buffer or bin no longer matches its
+   stamp and is discarded when it is next passed over. To dispatch an event, a
+   thread likewise advances the stamp from the value the event carries. Of a
+   cancellation and a dispatch racing for the same event, therefore, exactly
+   one succeeds, and 'ConcCancel' tells the caller which.
+
+At the start of each epoch one thread, with all the others waiting, calls
+'ConcEpoch' with the end of the epoch. The bins the epoch covers are then
+claimed one at a time by the threads calling 'ConcNext'. A thread claiming a bin
+takes out the events of the epoch, sorts them, and hands them out in order of
+time; the events of a bin are thus dispatched in order, while those of different
+bins go to different threads. When 'ConcNext' returns zero to a thread, no bins
+remain unclaimed, and the thread waits for the others at the end of the epoch.
+
+The number and width of the bins are fixed when the queue is started, since
+rebuilding them would need every thread to stop. They are best chosen, as in
+'schedule.c', for about one pending event per bin and about one event coming due
+as each bin is passed. Times are kept in floating point. This module and the one
+in 'schedule.c' are independent, and both may be used in the same program.
+
+The program 'qstress.c' runs this queue with up to 32 threads against a serial
+run of the calendar queue in 'schedule.c' and checks that every epoch dispatches
+the same events, and it measures the rate of dispatch for each number of threads.
+*/
+
+#include "common.h"
+#include <sched.h>
+
+#define CI 16          //Longest list sorted by simple insertion.
+#define CA 8           //Events for which room is made at first in a bin.
+
+struct Cent            //STRUCTURE OF EACH EVENT IN A BUFFER OR BIN        BYTES
+{ dec t;               //Time of the event                                    8
+  int n;               //Number of the event                                  4
+  unsigned s;          //Stamp with which it was scheduled                    4
+};                     //                                                    16
+
+struct Cbin            //STRUCTURE OF EACH BIN                             BYTES
+{ struct Cent *e;      //Events of the bin, in no particular order            8
+  int c;               //Number of events in the bin                          4
+  int a;               //Number of events for which there is room             4
+  int lock;            //Nonzero while a thread holds the bin                 4
+  int u[3];            //Unused (pads the bin to 32 bytes)                   12
+};                     //                                                    32
+
+struct Cthr            //STRUCTURE OF EACH THREAD'S PART                   BYTES
+{ struct Cent *b;      //Events scheduled and not yet merged                  8
+  int bc, ba;          //Their number and the room for them                   8
+  struct Cent *r;      //Events taken from a bin, in order of time            8
+  int rh, rc, ra;      //Next to dispatch, number, and room                  12
+  unsigned j;          //State of the random yields (see 'ConcJitter')        4
+  long ns, nc, nd, nw; //Events scheduled, cancelled, and dispatched by the  32
+                       //thread, and the times it waited for a bin
+  char v[56];          //Unused (keeps the threads' parts on separate        56
+};                     //cache lines)                                       128
+
+static unsigned *G;    //Stamp of each event, odd while it is scheduled.
+static int Gn = 0;     //Number of elements in 'G'.
+static struct Cbin *C; //The bins.
+static int Cn = 0;     //Number of bins, a power of two.
+static dec Cw;         //Width of each bin.
+static dec Cb;         //Time from which bins are counted.
+static struct Cthr *H; //Each thread's part, aligned.
+static void *Hm;       //Memory allocated for the threads' parts.
+static int Hn = 0;     //Number of threads.
+
+static dec Ce0, Ce1;   //Start and end of the present epoch.
+static long long Cf;   //First bin of the epoch, counted from 'Cb'.
+static int Cm;         //Number of bins in the epoch.
+static int Ci;         //Next bin of the epoch to be claimed.
+static int Cj = 0;     //Yield once in about this many chances, if nonzero.
+
+static int Lock(int, struct Cbin*), Add(struct Cbin*, struct Cent*);
+static int Claim(int, int), Order(struct Cent*, int), Jitter(int);
+
+#define CBIN(te)  ((long long)floor(((te)-Cb)/Cw)) //Bin of a time, uncircled.
+#define LIVE(e)   (__atomic_load_n(&G[(e)->n], __ATOMIC_ACQUIRE)==(e)->s)
+#define STEP(p,s) __atomic_compare_exchange_n(p, &(s), (s)+1, 0, \
+                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)   //Advance a stamp.
+#define UNLOCK(b) __atomic_store_n(&(b)->lock, 0, __ATOMIC_RELEASE)
+#define JITTER(k) if(Cj) Jitter(k)           //Perhaps yield (for testing).
+
+
+/*----------------------------------------------------------------------------*
+START THE QUEUE
+
+This routine releases any queue already started and starts a new one, empty. It
+must be called before any other routine in this module, and while no other
+thread is using the module.
+
+ENTRY: 'm' contains the highest event number that will be used.
+       'nb' contains the number of bins wanted and 'w' the width of each.
+       't0' contains the starting time, no later than any event.
+       'k' contains the number of threads, numbered 0 through 'k-1'.
+
+EXIT:  The queue is empty, with the first epoch ending at 't0', so that the
+         first call to 'ConcEpoch' starts the epoch beginning there.
+*/
+
+int ConcInit(int m, int nb, dec w, dec t0, int k)
+{ int i;
+
+  if(m<1||nb<1||w<=0||k<1)                   //Check the arguments.
+    Error3(525., "m=",m, " nb=",nb, " k=",k);
+
+  for(i=0; i<Cn; i++) free(C[i].e);          //Release any queue already
+  for(i=0; i<Hn; i++) { free(H[i].b); free(H[i].r); } //started.
+  free(C); free(Hm); free(G);
+
+  for(Cn=1; Cn<nb; Cn*=2);                   //Allocate the stamps, the bins,
+  Gn = m+1; Hn = k;                          //rounded up to a power of two,
+  G = (unsigned*)   calloc(Gn, sizeof(unsigned)); //and the threads' parts.
+  C = (struct Cbin*)calloc(Cn, sizeof(struct Cbin));
+  Hm = calloc(Hn+1, sizeof(struct Cthr));    //(The parts are aligned so that
+  if(G==0||C==0||Hm==0) Error(911.);         //each fills two cache lines.)
+  H = (struct Cthr*)(((size_t)Hm+63) & ~(size_t)63);
+
+  Cw = w; Cb = Ce0 = Ce1 = t0;               //Set the times.
+  Cf = Cm = Ci = 0;
+  for(i=0; i<Hn; i++) H[i].j = 2*i+1;        //Start each thread's sequence of
+  return 0;                                  //random yields.
+}
+
+
+/*----------------------------------------------------------------------------*
+SCHEDULE NEW EVENT
+
+This routine may be called by any thread at any time, each thread with its own
+number. The event is added to the thread's buffer.
+
+ENTRY: 'k' contains the number of the calling thread.
+       'n' contains the number of an event which is not scheduled.
+       'te' contains its time, no earlier than the end of the present epoch.
+
+EXIT:  The event is scheduled, in the thread's buffer.
+*/
+
+int ConcSchedule(int k, int n, dec te)
+{ unsigned s; struct Cthr *x;
+
+  if(n<1||n>=Gn) Error1(734.8, "n=",n);      //Check the event and its time.
+  if(te<Ce1) Error2(747., "t=",Ce1, ">",te);
+
+  s = __atomic_load_n(&G[n], __ATOMIC_ACQUIRE); JITTER(k);
+  if((s&1) || !STEP(&G[n], s))               //Mark the event scheduled, making
+    Error1(735.8, "n=",n);                   //sure it was not already.
+
+  x = &H[k];
+  if(x->bc>=x->ba)                           //Add the event to the buffer,
+  { x->ba = max(1024, 2*x->ba);              //making room if necessary.
+    x->b = (struct Cent*)realloc(x->b, x->ba*sizeof(struct Cent));
+    if(x->b==0) Error(911.); }
+  x->b[x->bc].t = te; x->b[x->bc].n = n; x->b[x->bc].s = s+1;
+  x->bc += 1; x->ns += 1;
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+CANCEL EVENT
+
+This routine may be called by any thread at any time, for an event scheduled by
+any thread. It finds nothing and takes no lock; the event itself is discarded
+later, when its buffer is merged or its bin taken.
+
+ENTRY: 'k' contains the number of the calling thread.
+       'n' contains the number of an event.
+
+EXIT:  'ConcCancel' contains one if the event was scheduled and has been
+         cancelled, or zero if it was not scheduled, as when it has just been
+         taken for dispatch by another thread.
+*/
+
+int ConcCancel(int k, int n)
+{ unsigned s;
+
+  if(n<1||n>=Gn) Error1(734.9, "n=",n);      //Check the event.
+
+  s = __atomic_load_n(&G[n], __ATOMIC_ACQUIRE); JITTER(k);
+  while(s&1)                                 //While it is scheduled, try to
+    if(STEP(&G[n], s))                       //mark it not, counting it if that
+    { H[k].nc += 1; return 1; }              //succeeds.
+  return 0;
+}
+
+/*
+Note: A failed compare and exchange loads the present stamp into 's', so the loop
+tries again only if another thread changed the stamp in the meantime, and stops
+as soon as the stamp shows the event no longer scheduled.
+*/
+
+
+/*----------------------------------------------------------------------------*
+MERGE BUFFER INTO BINS
+
+This routine may be called by any thread at any time, for its own buffer.
+
+ENTRY: 'k' contains the number of the calling thread.
+
+EXIT:  The events in the thread's buffer that are still scheduled have been
+         added to their bins, and the buffer is empty.
+*/
+
+int ConcMerge(int k)
+{ int j; struct Cthr *x; struct Cent *e; struct Cbin *b;
+
+  x = &H[k];
+  for(j=0; j<x->bc; j++)                     //For each event that has not been
+  { e = &x->b[j];                            //cancelled, lock its bin, add the
+    if(!LIVE(e)) continue;                   //event, and release the bin.
+    b = &C[CBIN(e->t)&(Cn-1)];
+    Lock(k, b); Add(b, e); JITTER(k); UNLOCK(b); }
+  x->bc = 0;
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+START AN EPOCH
+
+This routine is called by one thread while all the others wait, after every
+thread has finished dispatching the events of the previous epoch.
+
+ENTRY: 'e1' contains the end of the new epoch, which starts where the last one
+         ended.
+
+EXIT:  All buffers have been merged into the bins.
+       The bins covering the new epoch are ready to be claimed by 'ConcNext'.
+       'ConcEpoch' contains the number of events scheduled, in buffers or bins.
+*/
+
+long ConcEpoch(dec e1)
+{ int k; long p;
+
+  if(e1<=Ce1) Error2(525., "t=",Ce1, " e1=",e1);
+
+  for(p=k=0; k<Hn; k++)                      //Merge every buffer and count the
+  { ConcMerge(k);                            //events still scheduled.
+    p += H[k].ns-H[k].nc-H[k].nd; }
+
+  Ce0 = Ce1; Ce1 = e1;                       //Find the bins the epoch covers,
+  Cf = CBIN(Ce0);                            //no more than all of them, and
+  Cm = (int)min(CBIN(Ce1)-Cf+1, (long long)Cn); //start claiming them from the
+  __atomic_store_n(&Ci, 0, __ATOMIC_RELEASE);//first.
+  return p;
+}
+
+
+/*----------------------------------------------------------------------------*
+TAKE NEXT EVENT
+
+This routine may be called by any number of threads at once during an epoch.
+Each thread dispatches in order of time the events of each bin it claims.
+
+ENTRY: 'k' contains the number of the calling thread.
+
+EXIT:  'ConcNext' contains the number of the next event for the thread, which
+         is no longer scheduled, or zero if no events of the epoch remain for
+         it.
+       'te' contains the time of the event, within the epoch.
+*/
+
+int ConcNext(int k, dec *te)
+{ int j; unsigned s; struct Cthr *x; struct Cent *e;
+
+  x = &H[k];
+  while(1)
+  { while(x->rh<x->rc)                       //Take the next event taken from
+    { e = &x->r[x->rh++]; s = e->s;          //the bin, unless it has been
+      JITTER(k);
+      if(STEP(&G[e->n], s))                  //cancelled since, marking it
+      { x->nd += 1; *te = e->t;              //dispatched.
+        return e->n; } }
+
+    j = __atomic_fetch_add(&Ci, 1, __ATOMIC_ACQ_REL);
+    if(j>=Cm) return 0;                      //Claim the next bin of the epoch,
+    Claim(k, (int)((Cf+j)&(Cn-1))); }        //if any remain.
+}
+
+
+/*----------------------------------------------------------------------------*
+TAKE EVENTS OF THE EPOCH FROM A BIN
+
+ENTRY: 'k' contains the number of the calling thread, whose list of events
+         taken is exhausted.
+       'i' contains the number of a bin claimed by the thread.
+
+EXIT:  The events of the bin due before the end of the epoch have been moved to
+         the thread's list, in order of time, and those cancelled have been
+         discarded. The events of later epochs remain in the bin.
+*/
+
+static int Claim(int k, int i)
+{ int j, m; struct Cthr *x; struct Cbin *b; struct Cent *e;
+
+  x = &H[k]; b = &C[i]; x->rh = x->rc = 0;
+
+  Lock(k, b);
+  if(x->ra<b->c)                             //Make room for all the events of
+  { x->ra = max(x->ra*2, b->c);              //the bin.
+    x->r = (struct Cent*)realloc(x->r, x->ra*sizeof(struct Cent));
+    if(x->r==0) Error(911.); }
+
+  for(j=m=0; j<b->c; j++)                    //Move the events of this epoch to
+  { e = &b->e[j];                            //the list, discard those
+    if(!LIVE(e)) continue;                   //cancelled, and keep the others.
+    if(e->t<Ce1) x->r[x->rc++] = *e;
+    else b->e[m++] = *e; }
+  JITTER(k); b->c = m;
+  UNLOCK(b);
+
+  if(x->rc>1) Order(x->r, x->rc);            //Sort the events taken.
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+HOLD, ADD TO, AND SORT BINS
+
+'Lock' takes the lock of bin 'b' for thread 'k', yielding the processor while
+another thread holds it and counting the times it had to. 'Add' adds event 'e'
+to bin 'b', which the caller holds, making room if necessary. 'Order' sorts 'm'
+events by time, by insertion if they are few.
+*/
+
+static int Lock(int k, struct Cbin *b)
+{
+  if(__atomic_exchange_n(&b->lock, 1, __ATOMIC_ACQUIRE)==0) return 0;
+  H[k].nw += 1;
+  do { while(__atomic_load_n(&b->lock, __ATOMIC_RELAXED)) sched_yield(); }
+  while(__atomic_exchange_n(&b->lock, 1, __ATOMIC_ACQUIRE));
+  return 0;
+}
+
+static int Add(struct Cbin *b, struct Cent *e)
+{
+  if(b->c>=b->a)
+  { b->a = max(CA, 2*b->a);
+    b->e = (struct Cent*)realloc(b->e, b->a*sizeof(struct Cent));
+    if(b->e==0) Error(911.); }
+  b->e[b->c++] = *e;
+  return 0;
+}
+
+static int Cmp(const void *a, const void *b)
+{ dec d = ((struct Cent*)a)->t-((struct Cent*)b)->t;
+  return d<0? -1: d>0;
+}
+
+static int Order(struct Cent *r, int m)
+{ int i, j; struct Cent e;
+
+  if(m>CI) { qsort(r, m, sizeof(struct Cent), Cmp); return 0; }
+  for(i=1; i<m; i++)
+  { e = r[i];
+    for(j=i; j>0 && r[j-1].t>e.t; j--) r[j] = r[j-1];
+    r[j] = e; }
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+YIELD AT RANDOM
+
+For testing, the module can yield the processor at random at the moments where
+another thread's interference matters most: between reading a stamp and
+advancing it, and while holding a bin. This makes races that would otherwise
+need a thread to be preempted at just the wrong instant happen often, even on
+one processor. It must be set while no other thread is using the module.
+
+ENTRY: 'r' is zero to stop yielding, or about the number of such moments
+         between yields.
+*/
+
+int ConcJitter(int r)
+{
+  Cj = max(r, 0);
+  return 0;
+}
+
+static int Jitter(int k)
+{ unsigned x;
+
+  x = H[k].j;                                //Advance the thread's own
+  x ^= x<<13; x ^= x>>17; x ^= x<<5;         //sequence (xorshift), and yield
+  H[k].j = x;                                //now and then.
+  if(x%Cj==0) sched_yield();
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+REPORT THREADS' WORK
+
+ENTRY: 'k' contains the number of a thread.
+       's' points to an array of at least four elements.
+
+EXIT:  's' contains the number of events the thread has (0) scheduled, (1)
+         cancelled, and (2) dispatched, and (3) the number of times it waited
+         for a bin held by another thread.
+*/
+
+int ConcStats(int k, dec s[])
+{
+  s[0] = H[k].ns; s[1] = H[k].nc;
+  s[2] = H[k].nd; s[3] = H[k].nw;
+  return 0;
+}
+
+/* October 2026 [AGT]. */
@@ -0,0 +1,142 @@
+/*----------------------------------------------------------------------------*
+SCHEDULER REPLAY
+
+This program feeds the event scheduler in 'schedule.c' a trace of the calls made
+to it during an actual run of the model, recorded with 'EventTrace' (in the
+tuberculosis model, by running with 'qtrace=1'). Nothing of the model is
+involved, so the time taken is the scheduler's alone, and the work is exactly
+the mixture of scheduling, cancelling, rescheduling, renumbering, and
+dispatching that the model presents, with the times it actually uses, rather
+than the synthetic events of 'qbench.c'. A change to the scheduler can thus be
+timed on the same work before and after, and a change to the model cannot
+disturb the measurement.
+
+Each event dispatched is checked against the event recorded. The calendar queue
+dispatches exactly the events recorded. Other queues may take events at
+precisely the same time in a different order; when that happens the event
+dispatched is put back and the one recorded is taken in its place, so the replay
+can continue, and the number of such exchanges is displayed. An event at a
+different time is an error.
+
+The trace is replayed on each kind of event queue selectable through
+'EventType' in turn, or on only one of them if it is named on the command line,
+and repeated alternately, keeping the best time of each. The program is built
+with 'makeqr' and run as
+
+    qreplay file [q] [r]
+
+where 'file' is the trace, 'q' is the kind of queue, 0 through 3, as for
+'EventType' (default all), and 'r' is the number of times each replay is
+repeated (default 3). Each record of the trace takes 16 bytes. It is read in
+pieces, and only the time spent in the scheduler is counted.
+*/
+
+#include "common.h"
+
+#define QR_R 3             //Default number of repetitions.
+#define QR_B 65536         //Records read from the trace at a time.
+
+struct Qtrc                //Trace record, as written by 'EventTrace'.
+{ dec t; int n; int op; };
+
+extern dec t;              //Current time, from the scheduler.
+
+static struct Qtrc *X;     //Records of the trace read so far.
+static long xs;            //Number of exchanges of events at equal times.
+static int *Pv;            //New numbers collected for 'EventPermute',
+static int Pm, Pc, Pn0;    //the number expected and collected, and the first
+                           //event renumbered.
+
+static dec Replay(char*, int);
+
+static char *qname[] =     //Names of the kinds of queue.
+{ "Calendar", "Four-way heap", "Ladder", "Timing wheel" };
+
+main(int argc, char *argv[])
+{ int r, q, k, i; dec s, s0[4];
+
+  q = argc>2? atoi(argv[2]): -1;             //Collect the parameters of the
+  r = argc>3? atoi(argv[3]): QR_R;           //run.
+  if(argc<2||r<1||q<-1||q>3)
+    Error2(525., "q=",q, " r=",r);
+
+  X = (struct Qtrc*)malloc(QR_B*sizeof(struct Qtrc));
+  if(X==0) Error(911.);                      //Allocate the work area.
+
+  for(k=0; k<4; k++) s0[k] = 1e30;
+  for(i=0; i<r; i++)                         //Replay the trace on each kind of
+  for(k=0; k<4; k++)                         //queue, keeping the best time of
+  { if(q>=0 && k!=q) continue;               //each.
+    s = Replay(argv[1], k); if(s0[k]>s) s0[k] = s; }
+
+  for(k=0; k<4; k++)                         //Summarize the best times.
+    if(q<0 || k==q)
+      printf("%-14s best %.3f s\n", qname[k], s0[k]);
+  free(X);
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+REPLAY ONE TRACE
+
+ENTRY: 'name' contains the name of the file holding the trace.
+       'type' contains the kind of event queue, as for 'EventType'. Any kind
+         recorded in the trace is ignored.
+
+EXIT:  'Replay' contains the processor time used in the scheduler, in seconds.
+       A line summarizing the replay has been displayed.
+*/
+
+static dec Replay(char *name, int type)
+{ FILE *fp; int j, m, n; long k, d; dec te; clock_t c, cs; struct Qtrc *x;
+
+  fp = fopen(name, "rb");                    //Open the trace and start the
+  if(fp==0) Error1(510., name,0);            //queue afresh.
+  EventInit(); EventType(type);
+
+  cs = 0; k = d = xs = 0;
+  while((m=fread(X, sizeof(struct Qtrc), QR_B, fp))>0)
+  { c = clock();                             //Read the trace a piece at a
+    for(j=0; j<m; j++)                       //time and pass each operation to
+    { x = &X[j];                             //the scheduler.
+      switch(x->op)
+      { case 'T': EventStartTime(x->t);       break;
+        case 'Y':                             break;
+        case 'H': EventHorizon(x->t);         break;
+        case 'L': EventLoad(x->n);            break;
+        case 'Z': EventSize(x->n);            break;
+        case 'S': EventSchedule(x->n, x->t);  break;
+        case 'C': EventCancel(x->n);          break;
+        case 'R': EventReschedule(x->n, x->t);break;
+        case 'N': EventRenumber(x->n, (int)x->t); break;
+        case 'P': Pn0 = x->n; Pm = (int)x->t; //Collect the new numbers of a
+          Pv = (int*)realloc(Pv,              //bulk renumbering, which
+                 (Pm+1)*sizeof(int));         //follow, and renumber when
+          if(Pv==0) Error(911.);              //they are all in hand.
+          Pc = 0; if(Pm==0) EventPermute(Pv, Pn0, 0);
+          break;
+        case 'p': if(Pc>=Pm) Error2(513., name,0, " k=",k+j);
+          Pv[Pc++] = x->n;
+          if(Pc==Pm) EventPermute(Pv, Pn0, Pm);
+          break;
+        case 'X': n = EventNext(); d += 1;    //Dispatch the next event and
+          if(n==x->n) break;                  //make sure it is the one
+          if(n==0 || x->n==0 || t!=x->t)      //recorded, exchanging it for
+            Error3(744., "k=",k+j, " n=",n, " trace n=",x->n);
+          EventSchedule(n, t);                //that one if they are at the
+          EventCancel(x->n); xs += 1;         //same time.
+          break;
+        default: Error2(513., name,0, " k=",k+j); } }
+    cs += clock()-c; k += m; }
+
+  if(ferror(fp)) Error1(511., name,0);       //Make sure the whole trace was
+  fclose(fp);                                //read.
+
+  te = (dec)cs/CLOCKS_PER_SEC;               //Display the results.
+  printf("%-14s %10ld operations %10ld events %8.3f s %10.0f per second,"
+    " %ld exchanged, t=%.6f\n", qname[type], k, d, te, k/te, xs, t);
+  return te;
+}
+
+/* October 2026 [AGT]. */
@@ -0,0 +1,393 @@
+/*----------------------------------------------------------------------------*
+STRESS TEST OF CONCURRENT SCHEDULING
+
+This program runs the concurrent queue in 'qconc.c' with several threads
+scheduling, cancelling, and dispatching events at once, and checks every epoch
+against a serial run of the calendar queue in 'schedule.c'. It then times the
+concurrent queue with each number of threads in turn.
+
+Each individual has one pending event. Dispatching it schedules the individual's
+next event at least one epoch later, and sometimes acts on a second event, the
+individual's "target": if the target is pending it is cancelled, and then it may
+be scheduled anew, close to the individual's next event, so that the two are
+often due in the same epoch. A target scheduled for a later epoch must still be
+pending and must be cancelled successfully. A target due in the present epoch, however,
+may be dispatched by another thread at the very moment it is cancelled; either
+the dispatch or the cancellation wins, and exactly one of the two must. Either
+way the target's instance is "resolved" in this epoch, and what happens next
+does not depend on which way it went. All choices are made from a hash of the
+event's number and time rather than from a shared random number sequence, so
+they do not depend on which thread makes them or in what order.
+
+The serial run dispatches the same events one at a time in order of time, and
+settles each race the way the order of time settles it. For each epoch it
+records the number of individuals' events dispatched and the number of targets
+resolved, and a checksum of each (the sum, modulo 2^64, of a hash of number and
+time, which does not depend on the order of the events). The concurrent run must
+match every one of these in every epoch. At the end every individual must still
+be pending, and for every target the number of times it was scheduled must equal
+the number of times it was dispatched plus the number it was cancelled. Any
+difference is error 746.
+
+The threads merge their buffers every few events during an epoch, so merging
+into bins overlaps with other threads taking events from bins. A check that
+finds races needs threads to be interrupted at awkward moments, which happens
+even on one processor, since the threads are preempted; to make it happen far
+more often, the first run for each number of threads yields the processor at
+random in the middle of acting on targets and, through 'ConcJitter', inside the
+queue between reading a stamp and advancing it and while holding a bin. The
+check also uses only a few bins, so that threads often want the same bin at
+once. The second run does not yield, has about one bin for each pending event,
+and is timed.
+
+The program is built with 'makeqs' and run as
+
+    qstress [n] [e] [L] [k]
+
+where 'n' is the number of individuals (default 100,000), 'e' is the number of
+epochs (default 2000), 'L' is the length of each epoch (default 0.1), and 'k' is
+the number of threads (default 1, 2, 4, 8, 16, and 32 in turn). For each number
+of threads it displays the time of each run, the rate of dispatch in the timed
+run and that rate relative to one thread, and the number of times a thread
+waited for a bin held by another. The rate depends on the number of processors
+the threads can actually run on.
+*/
+
+#include "common.h"
+#include <pthread.h>
+#include <sched.h>
+
+#define QS_N  100000       //Default number of individuals.
+#define QS_E  2000         //Default number of epochs.
+#define QS_EL 0.1          //Default length of each epoch.
+#define QS_K  32           //Most threads.
+#define QS_T0 1981.        //Starting time.
+#define QS_L  30.          //Mean time between an individual's events.
+#define QS_PT 0.5          //Events that act on their target.
+#define QS_PS 0.6          //Of those, portion that schedule it anew.
+#define QS_Y  (1./64)      //Portion of those that yield the processor first.
+#define QS_MG 64           //Events dispatched between merges of a buffer.
+#define QS_J  4            //Chances between yields within the queue.
+#define QS_B  64           //Bins in the check, each a sixteenth of an epoch.
+
+#define EB(j) (QS_T0+(j)*L)     //Start of epoch 'j'.
+#define GOLD  0x9E3779B97F4A7C15ULL
+
+typedef unsigned long long hash;
+
+extern dec t;              //Current time, from the serial scheduler.
+
+static int qn, ne, Y;      //Individuals, epochs, and whether to yield.
+static dec L;              //Length of each epoch.
+
+static dec  *Tv;           //Time each target was last scheduled, and whether
+static char *Lv;           //it may be pending.
+static long *Sc, *Cv, *Dv; //Times each target was scheduled, cancelled by its
+                           //owner, and dispatched.
+static char *P;            //Events pending in the serial run.
+
+static long (*Rc)[2];      //Individuals dispatched and targets resolved in
+static hash (*Rh)[2];      //each epoch of the serial run, and their checksums.
+
+static struct Acc          //The same for the present epoch, for each thread
+{ long c[2];               //and the serial run, each on its own cache line.
+  hash h[2];
+  char u[32];
+} Sum[QS_K+1] __attribute__((aligned(64)));
+
+static pthread_barrier_t Bar;
+
+int ConcInit(int, int, dec, dec, int), ConcSchedule(int, int, dec),
+    ConcCancel(int, int), ConcMerge(int), ConcNext(int, dec*),
+    ConcStats(int, dec*), ConcJitter(int);
+long ConcEpoch(dec);
+int EventInit(), EventSize(int), EventStartTime(dec), EventSchedule(int, dec),
+    EventCancel(int), EventNext();
+
+static hash Mix(int, dec);
+static dec U(hash, int), Exp(dec), Wall(void), Serial(void), Conc(int, int);
+static int Start(int), Act(int, int, int, dec), Tally(int);
+static long Waits(int);
+static void *Work(void*);
+
+static int thr[] = { 1, 2, 4, 8, 16, 32 };   //Default numbers of threads.
+
+int main(int argc, char *argv[])
+{ int i, r, k, k1; long m, w[2]; dec s0, s1, s2, r1;
+
+  qn = argc>1? atoi(argv[1]): QS_N;          //Collect the size of the run.
+  ne = argc>2? atoi(argv[2]): QS_E;
+  L  = argc>3? atof(argv[3]): QS_EL;
+  k1 = argc>4? atoi(argv[4]): 0;
+  if(qn<1||ne<1||L<=0||k1<0||k1>QS_K)
+    Error3(525., "n=",qn, " e=",ne, " k=",k1);
+
+  Tv = (dec*) calloc(qn+1, sizeof(dec));     //Allocate the targets, the serial
+  Lv = (char*)calloc(qn+1, sizeof(char));    //run's pending events, and the
+  Sc = (long*)calloc(qn+1, sizeof(long));    //record of each epoch.
+  Cv = (long*)calloc(qn+1, sizeof(long));
+  Dv = (long*)calloc(qn+1, sizeof(long));
+  P  = (char*)calloc(2*qn+1, sizeof(char));
+  Rc = (long(*)[2])calloc(ne, sizeof *Rc);
+  Rh = (hash(*)[2])calloc(ne, sizeof *Rh);
+  if(Tv==0||Lv==0||Sc==0||Cv==0||Dv==0||P==0||Rc==0||Rh==0) Error(911.);
+
+  s0 = Serial();                             //Run the serial reference.
+  for(m=i=0; i<ne; i++) m += Rc[i][0]+Rc[i][1];
+  printf("%d individuals, %d epochs of %g, %ld events.\n", qn, ne, L, m);
+  printf("Serial calendar queue %8.3f s %10.0f events/s\n\n", s0, m/s0);
+  printf("threads  check (s)  timed (s)   events/s  relative  waits, check"
+    " and timed\n");
+
+  r = k1? 1: sizeof thr/sizeof thr[0];
+  for(r1=0, i=0; i<r; i++)                   //Run each number of threads,
+  { k = k1? k1: thr[i];                      //first yielding at random and then
+    s1 = Conc(k, 1); w[0] = Waits(k);        //timed.
+    s2 = Conc(k, 0); w[1] = Waits(k);
+    if(r1==0) r1 = m/s2;
+    printf("%7d %10.3f %10.3f %10.0f %9.2f %12ld %6ld\n",
+      k, s1, s2, m/s2, m/s2/r1, w[0], w[1]); }
+  printf("All epochs identical to the serial run.\n");
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+SERIAL REFERENCE
+
+EXIT:  'Rc' and 'Rh' contain the counts and checksums of each epoch.
+       'Serial' contains the elapsed time, in seconds.
+*/
+
+static dec Serial()
+{ int j, n; dec s;
+
+  EventInit(); EventSize(2*qn); EventStartTime(QS_T0);
+  Start(-1);
+
+  s = Wall(); j = 0;
+  while((n=EventNext())!=0)                  //Dispatch each event in order,
+  { while(t>=EB(j+1))                        //recording each epoch as it ends.
+    { Rc[j][0] = Sum[QS_K].c[0]; Rh[j][0] = Sum[QS_K].h[0];
+      Rc[j][1] = Sum[QS_K].c[1]; Rh[j][1] = Sum[QS_K].h[1];
+      memset(&Sum[QS_K], 0, sizeof Sum[QS_K]);
+      if(++j>=ne) return Wall()-s; }
+    P[n] = 0; Act(-1, j, n, t); }
+  Error(746.);                               //(The queue never empties.)
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+CONCURRENT RUN
+
+ENTRY: 'k' contains the number of threads.
+       'y' is nonzero to yield the processor at random.
+
+EXIT:  Every epoch has matched the serial run, and the final state of each
+         event has been checked.
+       'Conc' contains the elapsed time, in seconds, for dispatching.
+*/
+
+static dec Conc(int k, int y)
+{ int i; pthread_t th[QS_K]; dec s;
+
+  if(y) ConcInit(2*qn, QS_B, L/16, QS_T0, k);//Start the queue, with few bins
+  else ConcInit(2*qn, 2*qn, QS_L/qn, QS_T0, k); //to check, so that threads
+  Start(0); ConcEpoch(EB(1));                //contend for them, or about one
+  memset(Sum, 0, sizeof Sum); Y = y;         //for each event pending and each
+  ConcJitter(y? QS_J: 0);                    //coming due to time it.
+  if(pthread_barrier_init(&Bar, 0, k)) Error(911.);
+
+  s = Wall();                                //Run the threads.
+  for(i=1; i<k; i++)
+    if(pthread_create(&th[i], 0, Work, (void*)(long)i)) Error(911.);
+  Work((void*)0L);
+  for(i=1; i<k; i++) pthread_join(th[i], 0);
+  s = Wall()-s;
+  pthread_barrier_destroy(&Bar);
+
+  for(i=1; i<=qn; i++)                       //Every individual must be pending,
+  { if(ConcCancel(0, i)==0) Error1(746., "n=",i);  //and every target accounted
+    if(ConcCancel(0, i+qn)) Cv[i] += 1;      //for.
+    if(Sc[i]!=Cv[i]+Dv[i])
+      Error3(746., "n=",i+qn, " scheduled=",Sc[i], " resolved=",Cv[i]+Dv[i]); }
+  if(ConcEpoch(EB(ne+1))!=0) Error(746.);    //Nothing must remain.
+  return s;
+}
+
+
+/*----------------------------------------------------------------------------*
+THREAD
+
+Each thread dispatches events until none of the epoch remain for it, merging its
+buffer now and then, and waits for the others. Thread 0 then checks the epoch and
+starts the next while the others wait again.
+
+ENTRY: 'a' contains the number of the thread.
+*/
+
+static void *Work(void *a)
+{ int k, j, n; long d; dec te;
+
+  k = (int)(long)a; d = 0;
+  for(j=0; j<ne; j++)
+  { while((n=ConcNext(k, &te))!=0)
+    { Act(k, j, n, te);
+      if(++d%QS_MG==0) ConcMerge(k); }
+    ConcMerge(k);
+    pthread_barrier_wait(&Bar);
+    if(k==0) { Tally(j); if(j+1<ne) ConcEpoch(EB(j+2)); }
+    pthread_barrier_wait(&Bar); }
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+START EVENTS
+
+ENTRY: 'k' is -1 for the serial run, otherwise zero.
+
+EXIT:  The targets are cleared and each individual has its first event.
+*/
+
+static int Start(int k)
+{ int n;
+
+  memset(Lv, 0, qn+1); memset(P, 0, 2*qn+1);
+  memset(Sc, 0, (qn+1)*sizeof(long));
+  memset(Cv, 0, (qn+1)*sizeof(long));
+  memset(Dv, 0, (qn+1)*sizeof(long));
+  for(n=1; n<=qn; n++)
+    if(k<0) { EventSchedule(n, QS_T0+QS_L*Exp(U(Mix(n,QS_T0),0))); P[n] = 1; }
+    else ConcSchedule(k, n, QS_T0+QS_L*Exp(U(Mix(n,QS_T0),0)));
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+ACT ON EVENT
+
+ENTRY: 'k' contains the number of the thread, or -1 for the serial run.
+       'j' contains the present epoch.
+       'n' contains an event just dispatched and 'te' its time.
+
+EXIT:  The event has been counted, and any further events scheduled and
+         cancelled.
+*/
+
+#define SCHED(n,te)  (k<0? (EventSchedule(n,te), P[n] = 1): \
+                       ConcSchedule(k,n,te))
+#define CANCEL(n)    (k<0? (P[n]? (EventCancel(n), P[n] = 0, 1): 0): \
+                       ConcCancel(k,n))
+
+static int Act(int k, int j, int n, dec te)
+{ int i; hash h; dec e0, e1, tf, tn; struct Acc *a;
+
+  a = &Sum[k<0? QS_K: k];
+  e0 = EB(j); e1 = EB(j+1); h = Mix(n, te);
+  if(te<e0||te>=e1) Error3(746., "n=",n, " t=",te, " epoch=",j);
+
+  if(n>qn)                                   //Count a target dispatched.
+  { a->c[1] += 1; a->h[1] += h;
+    if(k<0) Dv[n-qn] += 1;
+    else __atomic_fetch_add(&Dv[n-qn], 1, __ATOMIC_RELAXED);
+    return 0; }
+
+  a->c[0] += 1; a->h[0] += h;                //Count an individual's event and
+  tf = max(te+L, e1);                        //schedule its next, no earlier
+  tn = tf+QS_L*Exp(U(h,1));                  //than the lookahead allows.
+  SCHED(n, tn);
+  if(U(h,2)>=QS_PT) return 0;
+
+  if(Y && U(h,5)<QS_Y) sched_yield();        //Act on the target. A target due
+  i = n;                                     //in a later epoch must be pending;
+  if(Lv[i])                                  //one due in this epoch may have
+  { if(Tv[i]>=e1)                            //been dispatched already, and if
+    { if(CANCEL(i+qn)==0) Error1(746., "n=",i+qn); //not it is resolved here.
+      Cv[i] += 1; }
+    else if(Tv[i]>=e0 && CANCEL(i+qn))
+    { Cv[i] += 1;
+      a->c[1] += 1; a->h[1] += Mix(i+qn, Tv[i]); }
+    Lv[i] = 0; }
+  if(Y && U(h,6)<QS_Y) sched_yield();
+  if(U(h,3)<QS_PS)                           //Perhaps schedule it anew,
+  { Tv[i] = max(tf, tn+L*(U(h,4)-0.5));     //near the individual's next event.
+    Lv[i] = 1; Sc[i] += 1;
+    SCHED(i+qn, Tv[i]); }
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+CHECK EPOCH
+
+ENTRY: 'j' contains an epoch just finished by every thread.
+
+EXIT:  The threads' counts and checksums have been compared with the serial run
+         and cleared.
+*/
+
+static int Tally(int j)
+{ int k, i; long c[2]; hash h[2];
+
+  c[0] = c[1] = h[0] = h[1] = 0;
+  for(k=0; k<QS_K; k++)
+    for(i=0; i<2; i++)
+    { c[i] += Sum[k].c[i]; h[i] += Sum[k].h[i];
+      Sum[k].c[i] = Sum[k].h[i] = 0; }
+  for(i=0; i<2; i++)
+    if(c[i]!=Rc[j][i]||h[i]!=Rh[j][i])
+      Error3(746., "epoch=",j, " events=",c[i], " serial=",Rc[j][i]);
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+HASHES, INTERVALS, TIME, AND WAITS
+
+'Mix' hashes an event's number and time, 'U' derives the 'i'th uniform number in
+[0,1) from a hash, 'Exp' converts a uniform number to an exponential interval of
+mean one, 'Wall' returns elapsed time in seconds, and 'Waits' totals the times
+the first 'k' threads waited for a bin.
+*/
+
+static long Waits(int k)
+{ long w; dec x[4];
+
+  for(w=0; k-->0; ) { ConcStats(k, x); w += x[3]; }
+  return w;
+}
+
+static hash Fin(hash x)
+{
+  x ^= x>>30; x *= 0xBF58476D1CE4E5B9ULL;
+  x ^= x>>27; x *= 0x94D049BB133111EBULL;
+  return x^(x>>31);
+}
+
+static hash Mix(int n, dec te)
+{ hash b;
+
+  memcpy(&b, &te, sizeof b);
+  return Fin((hash)n*GOLD^Fin(b));
+}
+
+static dec U(hash h, int i)
+{
+  return (Fin(h+(hash)(i+1)*GOLD)>>11)*(1./9007199254740992.);
+}
+
+static dec Exp(dec u)
+{
+  return -log(1-u);
+}
+
+static dec Wall()
+{ struct timespec s;
+
+  clock_gettime(CLOCK_MONOTONIC, &s);
+  return s.tv_sec+s.tv_nsec*1e-9;
+}
+
+/* October 2026 [AGT]. */
@@ -0,0 +1,870 @@
+/*----------------------------------------------------------------------------*
+ALTERNATIVE EVENT QUEUES
+
+The calendar queue in 'schedule.c' is fast when the times of pending events are
+spread evenly over the width of its bins, but its speed depends on how the
+distribution of event times interacts with that width. This module supplies
+three other queues with different strengths, any of which can stand in for the
+calendar queue. The choice is made once, at startup, through 'EventType', and
+thereafter 'EventSchedule', 'EventCancel', 'EventNext' and the other entry
+points in 'schedule.c' pass their work to the queue selected. Nothing in the
+calling program changes.
+
+1. A four-way indexed heap ('Heap...'). Every operation is 'O(log n)' whatever
+   the distribution of times. Each node has four children rather than two,
+   which halves the depth of the tree, and the heap is aligned so that the four
+   children of a node share one 64-byte cache line. The time of each event is
+   kept in the heap beside its number, so comparisons do not reach out into
+   other arrays.
+
+2. A ladder queue ('Ladder...'), after Tang, Goh and Thng (ACM Transactions on
+   Modeling and Computer Simulation 15:175-204, 2005). New events far in the
+   future are dropped unsorted into a "top" list. When they are needed they are
+   spread into a "rung" of buckets sized to the events actually present, and
+   any bucket found crowded is itself spread into a finer rung beneath it,
+   until the events about to be dispatched are few enough to sort into a
+   "bottom" list. It adapts to the distribution of times without tuning.
+
+3. A hierarchical timing wheel ('Wheel...'). Times are converted to integer
+   ticks and each event is placed by the most significant byte in which its
+   tick differs from the present tick, one wheel of 256 slots per byte. As time
+   advances, the slots of the coarser wheels are poured down into the finer
+   ones. Scheduling and cancelling are constant time, and bitmaps of occupied
+   slots make it quick to skip empty stretches.
+
+The three queues are allocated only when selected, so a program using the
+calendar queue pays nothing for them. Each is allocated for the range of event
+numbers provided for in 'schedule.c' at the time, and is enlarged with it by
+'EventSize'.
+*/
+
+#include "common.h"
+
+static int PN;         //Number of event numbers provided for, as in
+                       //'schedule.c'.
+extern dec t;          //Current time, last dispatched event.
+
+static int LSort(int*, dec*, int, int);
+static void *Grow(void*, int, int, int);
+int LadderStart(dec), WheelStart(dec);
+
+
+/*============================================================================*
+FOUR-WAY INDEXED HEAP
+
+The heap is stored in 'Hh', with the root at 'Hh[HR]' and the children of node
+'a' at 'Hh[4a-8]' through 'Hh[4a-5]'. Starting the root at 3 rather than 0 puts
+every family of four children at an index divisible by four, hence in a single
+cache line once the array is aligned. 'Hx[n]' is the position of event 'n' in
+the heap, or zero if it is not scheduled.
+*/
+
+#define HR 3                   //Position of the root.
+#define HC(a) (4*(a)-8)        //First child of node 'a'.
+#define HP(a) (((a)+8)/4)      //Parent of node 'a'.
+
+struct Hent                    //STRUCTURE OF EACH HEAP NODE               BYTES
+{ dec t;                       //Time of the event                           8
+  int n;                       //Number of the event                         4
+  int x;                       //Unused (pads the node to 16 bytes)          4
+};
+
+static struct Hent *Hh;        //Heap of pending events, aligned.
+static void *Hm;               //Memory allocated for the heap.
+static int *Hx;                //Position of each event in the heap.
+static int Hn;                 //Number of events in the heap.
+
+static int HeapUp(int, struct Hent), HeapDown(int, struct Hent);
+
+/*----------------------------------------------------------------------------*
+START OR STOP THE HEAP
+
+ENTRY: 'on' contains the number of event numbers to provide for, starting
+         with zero, if the heap is to be used, or zero if it is to be released.
+
+EXIT:  The heap is empty, and allocated if 'on' is nonzero.
+*/
+
+int HeapInit(int on)
+{
+  free(Hm); free(Hx); Hm = 0; Hx = 0;        //Release any prior heap.
+  Hh = 0; Hn = 0;
+  if(on==0) return 0;
+  PN = on;
+
+  Hm = calloc(PN+HR+8, sizeof(struct Hent)); //Allocate the heap and align it
+  Hx = (int*)calloc(PN, sizeof(int));        //on a cache line.
+  if(Hm==0||Hx==0) Error(911.);
+  Hh = (struct Hent*)(((size_t)Hm+63) & ~(size_t)63);
+  return 0;
+}
+
+int HeapStart(dec t0) { t = t0; return 0; }
+
+/*----------------------------------------------------------------------------*
+ENLARGE THE HEAP
+
+ENTRY: 'm' contains the number of event numbers to provide for, more than at
+         present.
+
+EXIT:  The heap and its positions have been enlarged, with the events in them
+         unchanged.
+*/
+
+int HeapSize(int m)
+{ void *h;
+
+  h = calloc(m+HR+8, sizeof(struct Hent));   //Move the heap to a larger area,
+  if(h==0) Error(911.);                      //aligned as before.
+  memcpy((struct Hent*)(((size_t)h+63) & ~(size_t)63), Hh,
+    (HR+Hn)*sizeof(struct Hent));
+  free(Hm); Hm = h;
+  Hh = (struct Hent*)(((size_t)Hm+63) & ~(size_t)63);
+
+  Hx = (int*)Grow(Hx, PN, m, sizeof(int));   //Enlarge the positions.
+  PN = m; return 0;
+}
+
+/*----------------------------------------------------------------------------*
+SCHEDULE, CANCEL, AND DISPATCH IN THE HEAP
+
+The entry and exit conditions are those of 'EventSchedule', 'EventCancel',
+'EventReschedule', 'EventRenumber', and 'EventNext' in 'schedule.c'.
+'HeapTime' gives the time of event 'n' in 'te', returning 1 if it is scheduled
+or 0 if not.
+*/
+
+int HeapSchedule(int n, dec te)
+{ struct Hent e;
+
+  if(Hx[n]) Error1(735.6, "n=",n);           //Make sure the event is not
+  if(te<t)  Error2(737.6, "t=",t, ">",te);   //already scheduled or in the past.
+
+  e.t = te; e.n = n; e.x = 0;                //Add it at the bottom of the heap
+  Hn += 1; HeapUp(HR+Hn-1, e);               //and let it rise to its place.
+  return 0;
+}
+
+int HeapCancel(int n)
+{ int a, last;
+
+  a = Hx[n]; if(a==0) Error1(736.6, "n=",n); //Find the event in the heap.
+  Hx[n] = 0;
+
+  last = HR+Hn-1; Hn -= 1;                   //Move the last event into its
+  if(a==last) return 0;                      //place and let that one rise or
+  if(a>HR && Hh[HP(a)].t>Hh[last].t)         //fall as needed.
+       HeapUp  (a, Hh[last]);
+  else HeapDown(a, Hh[last]);
+  return 0;
+}
+
+int HeapReschedule(int n, dec te)
+{ int a; struct Hent e;
+
+  a = Hx[n]; if(a==0) Error1(736.6, "n=",n); //Find the event in the heap and
+  if(te<t) Error2(737.6, "t=",t, ">",te);    //check its new time.
+
+  e = Hh[a]; e.t = te;                       //Change the time and let the event
+  if(a>HR && Hh[HP(a)].t>te) HeapUp(a, e);   //rise or fall as needed.
+  else                       HeapDown(a, e);
+  return 0;
+}
+
+int HeapRenumber(int n, int m)
+{ int a;
+
+  a = Hx[m]; if(a==0) Error1(736.6, "n=",m); //Put the new number in place of
+  if(Hx[n])  Error1(735.6, "n=",n);          //the old, leaving the time and
+  Hh[a].n = n; Hx[n] = a; Hx[m] = 0;         //position unchanged.
+  return 0;
+}
+
+int HeapTime(int n, dec *te)
+{
+  if(Hx[n]==0) return 0;                     //Give the time of a scheduled
+  *te = Hh[Hx[n]].t; return 1;               //event.
+}
+
+int HeapNext()
+{ struct Hent e;
+
+  if(Hn==0) return 0;                        //Signal when no events remain.
+
+  e = Hh[HR]; Hx[e.n] = 0; Hn -= 1;          //Take the root, move the last
+  if(Hn) HeapDown(HR, Hh[HR+Hn]);            //event into its place, and let
+  t = e.t; return e.n;                       //that one fall to its level.
+}
+
+/*----------------------------------------------------------------------------*
+MOVE A NODE UP OR DOWN THE HEAP
+
+ENTRY: 'a' indexes a vacant position in the heap.
+       'e' contains a node to be placed at or above it ('HeapUp') or at or below
+         it ('HeapDown').
+
+EXIT:  The node has been placed and the heap is in order.
+*/
+
+static int HeapUp(int a, struct Hent e)
+{ int p;
+
+  while(a>HR && Hh[p=HP(a)].t>e.t)           //While the parent is later, move
+  { Hh[a] = Hh[p]; Hx[Hh[a].n] = a; a = p; } //it down into the vacancy.
+
+  Hh[a] = e; Hx[e.n] = a;                    //Fill the vacancy with the node.
+  return a;
+}
+
+static int HeapDown(int a, struct Hent e)
+{ int c, i, ce, last;
+
+  last = HR+Hn-1;
+  while((c=HC(a))<=last)                     //Find the earliest of the four
+  { ce = c+4; if(ce>last+1) ce = last+1;     //children.
+    for(i=c+1; i<ce; i++)
+      if(Hh[i].t<Hh[c].t) c = i;
+
+    if(Hh[c].t>=e.t) break;                  //Stop if the node belongs here,
+    Hh[a] = Hh[c]; Hx[Hh[a].n] = a; a = c; } //else move that child up.
+
+  Hh[a] = e; Hx[e.n] = a;                    //Fill the vacancy with the node.
+  return a;
+}
+
+/*----------------------------------------------------------------------------*
+DISPLAY PROFILE OF THE HEAP
+
+EXIT:  A line describing the heap has been displayed.
+       'HeapProfile' contains the amount of memory allocated for it.
+*/
+
+int HeapProfile(char *label)
+{ int d; dec w, c;
+
+  for(d=0,w=0,c=1; w<Hn; d++,c*=4) w += c;  //Compute the depth of the heap.
+
+  printf("%s heap of %d events, four children per node, depth %d.\n",
+    label, Hn, d);
+  return (PN+HR+8)*sizeof(struct Hent) + PN*sizeof(int);
+}
+
+
+/*============================================================================*
+LADDER QUEUE
+
+Each pending event is on exactly one doubly linked list, through 'LN' and 'LP',
+and 'LL[n]' tells which: 1 for the top, 2 for the bottom, and 3 onward for the
+buckets of the rungs, or zero if the event is not scheduled. The buckets of
+rung 'r' are lists '3+Lb[r]' through '3+Lb[r]+Lnb[r]-1'. Rungs are created and
+exhausted in the manner of a stack, so their buckets are allocated the same way,
+each rung's beginning where the one above it ends.
+
+Rung 'r' covers times from 'Ls[r]' in 'Lnb[r]' buckets of width 'Lw[r]', of
+which 'Lk[r]' is the first not yet consumed. A new event goes into the top if it
+is not earlier than 'Ltop', otherwise into the coarsest rung whose unconsumed
+buckets reach back to it, otherwise into its place in the sorted bottom.
+*/
+
+#define LTHRES 50     //Events in a bucket above which a finer rung is made.
+#define LRUNGS 8      //Most rungs allowed.
+
+static dec *LT;       //Time of each event.
+static int *LN, *LP;  //Forward and backward links, ending with zero.
+static int *LL;       //List holding each event, or zero if none.
+static int *Lh, *Lc;  //Head and number of events of each list.
+static int Lcap;      //Number of lists allocated.
+static int Le;        //Number of events in the ladder.
+
+static dec Ltop;      //Earliest time that goes into the top.
+static dec Lmin;      //Earliest time in the top.
+static dec Lmax;      //Latest time in the top.
+
+static int Lr;                   //Number of rungs in use.
+static dec Ls[LRUNGS];           //Starting time of each rung.
+static dec Lw[LRUNGS];           //Width of each bucket of each rung.
+static int Lb[LRUNGS];           //First bucket of each rung, less three.
+static int Lnb[LRUNGS];          //Number of buckets in each rung.
+static int Lk[LRUNGS];           //First unconsumed bucket of each rung.
+static int Lnr[LRUNGS];          //Number of events in each rung.
+
+static int LPush(int, int), LDrop(int), LPlace(int), LRoom(int);
+static int LBucket(int, dec), LSpread(int, int, int), LDrain(int);
+
+/*----------------------------------------------------------------------------*
+START OR STOP THE LADDER
+
+ENTRY: 'on' contains the number of event numbers to provide for, starting
+         with zero, if the ladder is to be used, or zero if it is to be
+         released.
+
+EXIT:  The ladder is empty, and allocated if 'on' is nonzero.
+*/
+
+int LadderInit(int on)
+{
+  free(LT); free(LN); free(LP); free(LL);    //Release any prior ladder.
+  free(Lh); free(Lc);
+  LT = 0; LN = LP = LL = Lh = Lc = 0;
+  Lcap = Le = Lr = 0;
+  if(on==0) return 0;
+  PN = on;
+
+  LT = (dec*)calloc(PN, sizeof(dec));        //Allocate the links and times.
+  LN = (int*)calloc(PN, sizeof(int));
+  LP = (int*)calloc(PN, sizeof(int));
+  LL = (int*)calloc(PN, sizeof(int));
+  if(LT==0||LN==0||LP==0||LL==0) Error(911.);
+
+  LRoom(1024); LadderStart(t);               //Allocate the first lists.
+  return 0;
+}
+
+int LadderStart(dec t0)
+{ t = Ltop = t0;                             //Send everything to the top
+  Lmin = 1e300; Lmax = -1e300;               //until the first dispatch.
+  return 0;
+}
+
+int LadderSize(int m)
+{
+  LT = (dec*)Grow(LT, PN, m, sizeof(dec));   //Enlarge the links and times.
+  LN = (int*)Grow(LN, PN, m, sizeof(int));
+  LP = (int*)Grow(LP, PN, m, sizeof(int));
+  LL = (int*)Grow(LL, PN, m, sizeof(int));
+  PN = m; return 0;
+}
+
+/*----------------------------------------------------------------------------*
+SCHEDULE, CANCEL, AND DISPATCH IN THE LADDER
+
+The entry and exit conditions are those of 'EventSchedule', 'EventCancel',
+'EventReschedule', 'EventRenumber', and 'EventNext' in 'schedule.c'.
+'LadderTime' gives the time of event 'n' in 'te', returning 1 if it is scheduled
+or 0 if not.
+*/
+
+int LadderSchedule(int n, dec te)
+{
+  if(LL[n]) Error1(735.7, "n=",n);           //Make sure the event is not
+  if(te<t)  Error2(737.7, "t=",t, ">",te);   //already scheduled or in the past.
+
+  LT[n] = te; Le += 1;                       //Record the time and place the
+  LPlace(n); return 0;                       //event.
+}
+
+int LadderCancel(int n)
+{
+  if(LL[n]==0) Error1(736.7, "n=",n);        //Make sure the event is scheduled,
+  LDrop(n); Le -= 1; return 0;               //then remove it.
+}
+
+int LadderReschedule(int n, dec te)
+{
+  if(LL[n]==0) Error1(736.7, "n=",n);        //Make sure the event is scheduled
+  if(te<t) Error2(737.7, "t=",t, ">",te);    //and the time is not past.
+
+  LDrop(n); LT[n] = te;                      //Remove the event and place it
+  LPlace(n); return 0;                       //again at its new time.
+}
+
+int LadderRenumber(int n, int m)
+{ int L;
+
+  L = LL[m]; if(L==0) Error1(736.7, "n=",m); //Put the new number in place of
+  if(LL[n]) Error1(735.7, "n=",n);           //the old in its list.
+
+  LN[n] = LN[m]; LP[n] = LP[m]; LL[n] = L; LT[n] = LT[m];
+  if(LP[n]) LN[LP[n]] = n; else Lh[L] = n;
+  if(LN[n]) LP[LN[n]] = n;
+  LL[m] = 0; return 0;
+}
+
+int LadderTime(int n, dec *te)
+{
+  if(LL[n]==0) return 0;                     //Give the time of a scheduled
+  *te = LT[n]; return 1;                     //event.
+}
+
+int LadderNext()
+{ int n, r, L;
+
+  while(Le>0)
+  { if((n=Lh[2])!=0)                         //If the bottom is not empty,
+    { LDrop(n); Le -= 1;                     //dispatch its first event.
+      t = LT[n]; return n; }
+
+    if(Lr==0)                                //If there are no rungs, spread
+    { LSpread(0, 1, Lc[1]); continue; }      //the top into a new one.
+
+    r = Lr-1;                                //Otherwise work with the lowest
+    if(Lnr[r]==0) { Lr -= 1; continue; }     //rung, discarding it if empty.
+
+    while(Lc[L=3+Lb[r]+Lk[r]]==0) Lk[r]++;   //Find its first occupied bucket.
+
+    if(Lc[L]>LTHRES && Lr<LRUNGS)            //If the bucket is crowded, spread
+      LSpread(r+1, L, Lc[L]);                //it into a finer rung. Otherwise
+    else LDrain(r); }                        //sort it into the bottom.
+
+  Ltop = t;                                  //With no events left, send new
+  return 0;                                  //ones to the top.
+}
+
+/*----------------------------------------------------------------------------*
+PLACE AN EVENT IN THE LADDER
+
+ENTRY: 'n' indexes an event not on any list.
+       'LT[n]' contains its time.
+
+EXIT:  The event has been placed in the top, a rung, or the bottom.
+*/
+
+static int LPlace(int n)
+{ int r, j, jp; dec te;
+
+  te = LT[n];
+  if(te>=Ltop)                               //Put events that are not earlier
+  { if(Lmin>te) Lmin = te;                   //than 'Ltop' into the top.
+    if(Lmax<te) Lmax = te;
+    LPush(1, n); return 0; }
+
+  for(r=0; r<Lr; r++)                        //Put others into the coarsest rung
+    if(Lk[r]<Lnb[r] && te>=Ls[r]+Lk[r]*Lw[r])//that reaches back to them.
+    { LPush(3+Lb[r]+LBucket(r, te), n);
+      Lnr[r] += 1; return 0; }
+
+  for(jp=0,j=Lh[2]; j && LT[j]<=te; jp=j,j=LN[j]);
+
+  LP[n] = jp; LN[n] = j; LL[n] = 2;          //Put the rest into the bottom, in
+  if(jp) LN[jp] = n; else Lh[2] = n;         //order of time.
+  if(j)  LP[j]  = n;
+  Lc[2] += 1; return 0;
+}
+
+/*----------------------------------------------------------------------------*
+SPREAD EVENTS INTO A NEW RUNG
+
+ENTRY: 'r' contains the number of the new rung.
+       'L' contains the list to be spread, either the top or a crowded bucket
+         of rung 'r-1'.
+       'c' contains the number of events on that list, at least one.
+
+EXIT:  A new rung 'r' holds the events, the list is empty, and 'Lr' is 'r+1'.
+*/
+
+static int LSpread(int r, int L, int c)
+{ int j, jn, k; dec lo, hi;
+
+  if(r==0)                                   //From the top, span the times
+  { lo = Lmin; hi = Lmax; Ltop = Lmax;       //present and reset the top.
+    Lmin = 1e300; Lmax = -1e300;
+    Lb[0] = 0; }
+  else                                       //From a bucket, span the bucket
+  { lo = Ls[r-1]+Lk[r-1]*Lw[r-1];            //and mark it consumed.
+    hi = lo+Lw[r-1];
+    Lb[r] = Lb[r-1]+Lnb[r-1];
+    Lnr[r-1] -= c; Lk[r-1] += 1; }
+
+  Ls[r] = lo; Lnb[r] = c+1; Lk[r] = 0;       //Lay out the new rung, with about
+  Lw[r] = (hi-lo)/c; Lnr[r] = c;             //one event per bucket.
+  if(Lw[r]<=0) Lw[r] = 1;
+  LRoom(3+Lb[r]+Lnb[r]);
+  for(k=0; k<Lnb[r]; k++) Lh[3+Lb[r]+k] = Lc[3+Lb[r]+k] = 0;
+  Lr = r+1;
+
+  for(j=Lh[L]; j; j=jn)                      //Move every event on the list to
+  { jn = LN[j];                              //its bucket in the new rung.
+    LPush(3+Lb[r]+LBucket(r, LT[j]), j); }
+  Lh[L] = Lc[L] = 0;
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*
+SORT A BUCKET INTO THE BOTTOM
+
+ENTRY: 'r' contains the lowest rung.
+       'Lk[r]' indexes its first occupied bucket.
+       The bottom is empty.
+
+EXIT:  The events of the bucket form the bottom, in order of time.
+       The bucket is marked consumed.
+*/
+
+static int LDrain(int r)
+{ int L, j, jp;
+
+  L = 3+Lb[r]+Lk[r];
+  Lh[2] = LSort(LN, LT, Lh[L], Lc[L]);       //Sort the bucket by time and make
+  Lc[2] = Lc[L];                             //it the bottom.
+  for(jp=0,j=Lh[2]; j; jp=j,j=LN[j])
+  { LP[j] = jp; LL[j] = 2; }
+
+  Lnr[r] -= Lc[L]; Lk[r] += 1;               //Mark the bucket consumed.
+  Lh[L] = Lc[L] = 0;
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*
+LADDER SERVICE ROUTINES
+
+'LPush' adds event 'n' to the front of list 'L', 'LDrop' removes it from
+whatever list it is on, 'LBucket' finds the bucket of rung 'r' for time 'te',
+and 'LRoom' makes sure there are at least 'm' lists allocated.
+*/
+
+static int LPush(int L, int n)
+{
+  LN[n] = Lh[L]; LP[n] = 0; LL[n] = L;
+  if(Lh[L]) LP[Lh[L]] = n;
+  Lh[L] = n; Lc[L] += 1;
+  return 0;
+}
+
+static int LDrop(int n)
+{ int L, r;
+
+  L = LL[n];
+  if(LP[n]) LN[LP[n]] = LN[n]; else Lh[L] = LN[n];
+  if(LN[n]) LP[LN[n]] = LP[n];
+  LL[n] = 0; Lc[L] -= 1;
+
+  if(L>=3)                                   //If the event was in a rung,
+  { r = Lr-1;                                //count it out of that rung.
+    while(r>0 && 3+Lb[r]>L) r--;
+    Lnr[r] -= 1; }
+  return L;
+}
+
+static int LBucket(int r, dec te)
+{ dec x;
+
+  x = (te-Ls[r])/Lw[r];                      //Rounding can place a time just
+  if(x<Lk[r])    return Lk[r];               //outside the rung, in which case
+  if(x>=Lnb[r])  return Lnb[r]-1;            //it goes into the nearest bucket.
+  return (int)x;
+}
+
+static int LRoom(int m)
+{ int n;
+
+  if(m<=Lcap) return 0;
+  n = max(m, 2*Lcap);
+  Lh = (int*)realloc(Lh, n*sizeof(int));
+  Lc = (int*)realloc(Lc, n*sizeof(int));
+  if(Lh==0||Lc==0) Error(911.);
+  for(; Lcap<n; Lcap++) Lh[Lcap] = Lc[Lcap] = 0;
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*
+DISPLAY PROFILE OF THE LADDER
+
+EXIT:  A line describing the ladder has been displayed.
+       'LadderProfile' contains the amount of memory allocated for it.
+*/
+
+int LadderProfile(char *label)
+{
+  printf("%s ladder of %d events, %d in top, %d in bottom, %d rungs.\n",
+    label, Le, Lc[1], Lc[2], Lr);
+  return PN*(sizeof(dec)+3*sizeof(int)) + Lcap*2*sizeof(int);
+}
+
+
+/*============================================================================*
+HIERARCHICAL TIMING WHEEL
+
+Times are converted to ticks of 'WQ' per unit of time, counted from the starting
+time. 'Wt' is the present tick. An event at tick 'k' is placed on wheel 'L',
+where 'L' is the highest byte in which 'k' differs from 'Wt', in slot 'WS*L+b',
+where 'b' is the value of that byte of 'k'. Each slot is a doubly linked list
+through 'WN' and 'WP', and 'WX[n]' is one more than the slot holding event 'n',
+or zero if the event is not scheduled. Bit 'b' of 'Wm[L]' is set when slot 'b'
+of wheel 'L' is occupied.
+
+Events in the current slot of the finest wheel share a tick but not necessarily
+a time, so that slot is sorted before it is dispatched, as the current bin is
+in the calendar queue.
+*/
+
+#define WB 8                   //Bits of the tick per wheel.
+#define WS 256                 //Slots per wheel, 2^WB.
+#define WL 8                   //Number of wheels, 64/WB.
+#define WQ 1048576.0           //Ticks per unit of time, 2^20.
+
+typedef unsigned long long wbits;
+
+static dec *WT;                //Time of each event.
+static long long *WK;          //Tick of each event.
+static int *WN, *WP;           //Forward and backward links, ending with zero.
+static int *WX;                //Slot holding each event, plus one.
+static int Wh[WL*WS];          //First event in each slot.
+static wbits Wm[WL][WS/64];    //Occupied slots of each wheel.
+static long long Wt;           //Present tick.
+static dec Wb;                 //Time from which ticks are counted.
+static int We;                 //Number of events on the wheels.
+static int Wo;                 //Flag set if the present slot is in order.
+
+static int WPush(int, int), WDrop(int), WSlot(long long), WScan(int, int);
+
+/*----------------------------------------------------------------------------*
+START OR STOP THE WHEELS
+
+ENTRY: 'on' contains the number of event numbers to provide for, starting
+         with zero, if the wheels are to be used, or zero if they are to be
+         released.
+
+EXIT:  The wheels are empty, and allocated if 'on' is nonzero.
+*/
+
+int WheelInit(int on)
+{ int i;
+
+  free(WT); free(WK); free(WN); free(WP); free(WX);
+  WT = 0; WK = 0; WN = WP = WX = 0;          //Release any prior wheels.
+  for(i=0; i<WL*WS; i++) Wh[i] = 0;
+  for(i=0; i<WL*WS/64; i++) Wm[i/(WS/64)][i%(WS/64)] = 0;
+  We = 0; Wo = 1;
+  if(on==0) return 0;
+  PN = on;
+
+  WT = (dec*)calloc(PN, sizeof(dec));        //Allocate the links and times.
+  WK = (long long*)calloc(PN, sizeof(long long));
+  WN = (int*)calloc(PN, sizeof(int));
+  WP = (int*)calloc(PN, sizeof(int));
+  WX = (int*)calloc(PN, sizeof(int));
+  if(WT==0||WK==0||WN==0||WP==0||WX==0) Error(911.);
+
+  WheelStart(t);
+  return 0;
+}
+
+int WheelStart(dec t0)
+{ t = Wb = t0; Wt = 0;                       //Count ticks from the start.
+  return 0;
+}
+
+int WheelSize(int m)
+{
+  WT = (dec*)Grow(WT, PN, m, sizeof(dec));   //Enlarge the links and times.
+  WK = (long long*)Grow(WK, PN, m, sizeof(long long));
+  WN = (int*)Grow(WN, PN, m, sizeof(int));
+  WP = (int*)Grow(WP, PN, m, sizeof(int));
+  WX = (int*)Grow(WX, PN, m, sizeof(int));
+  PN = m; return 0;
+}
+
+/*----------------------------------------------------------------------------*
+SCHEDULE, CANCEL, AND DISPATCH ON THE WHEELS
+
+The entry and exit conditions are those of 'EventSchedule', 'EventCancel',
+'EventReschedule', 'EventRenumber', and 'EventNext' in 'schedule.c'.
+'WheelTime' gives the time of event 'n' in 'te', returning 1 if it is scheduled
+or 0 if not.
+*/
+
+#define WKEY(te) ((te)-Wb<1e12? (long long)(((te)-Wb)*WQ): (long long)(1e12*WQ))
+
+int WheelSchedule(int n, dec te)
+{
+  if(WX[n]) Error1(735.8, "n=",n);           //Make sure the event is not
+  if(te<t)  Error2(737.8, "t=",t, ">",te);   //already scheduled or in the past.
+
+  WT[n] = te; WK[n] = WKEY(te);              //Record the time and tick, and
+  WPush(WSlot(WK[n]), n); We += 1;           //place the event on its wheel.
+  return 0;
+}
+
+int WheelCancel(int n)
+{
+  if(WX[n]==0) Error1(736.8, "n=",n);        //Make sure the event is scheduled,
+  WDrop(n); We -= 1; return 0;               //then remove it.
+}
+
+int WheelReschedule(int n, dec te)
+{
+  if(WX[n]==0) Error1(736.8, "n=",n);        //Make sure the event is scheduled
+  if(te<t) Error2(737.8, "t=",t, ">",te);    //and the time is not past.
+
+  WDrop(n);                                  //Remove the event and place it
+  WT[n] = te; WK[n] = WKEY(te);              //again at its new time.
+  WPush(WSlot(WK[n]), n); return 0;
+}
+
+int WheelRenumber(int n, int m)
+{ int s;
+
+  s = WX[m]; if(s==0) Error1(736.8, "n=",m); //Put the new number in place of
+  if(WX[n]) Error1(735.8, "n=",n);           //the old in its slot.
+
+  WN[n] = WN[m]; WP[n] = WP[m]; WX[n] = s;
+  WT[n] = WT[m]; WK[n] = WK[m];
+  if(WP[n]) WN[WP[n]] = n; else Wh[s-1] = n;
+  if(WN[n]) WP[WN[n]] = n;
+  WX[m] = 0; return 0;
+}
+
+int WheelTime(int n, dec *te)
+{
+  if(WX[n]==0) return 0;                     //Give the time of a scheduled
+  *te = WT[n]; return 1;                     //event.
+}
+
+int WheelNext()
+{ int n, j, jp, s, b, L, h, jn;
+
+  while(We>0)
+  { s = Wt&(WS-1);                           //If the present slot of the finest
+    if((n=Wh[s])!=0)                         //wheel is occupied, sort it if
+    { if(Wo==0)                              //necessary and dispatch its first
+      { n = Wh[s] = LSort(WN, WT, n, 0);     //event.
+        for(jp=0,j=n; j; jp=j,j=WN[j]) WP[j] = jp;
+        Wo = 1; }
+      WDrop(n); We -= 1;
+      t = WT[n]; return n; }
+
+    for(L=0; L<WL; L++)                      //Otherwise find the next occupied
+    { b = WScan(L, (Wt>>(WB*L))&(WS-1));     //slot, on the finest wheel that
+      if(b>=0) break; }                      //has one.
+    if(L>=WL) Error(820.8);
+
+    if(L<WL-1) Wt = Wt>>(WB*(L+1))<<(WB*(L+1));
+    else       Wt = 0;                       //Advance the present tick to the
+    Wt |= (long long)b<<(WB*L); Wo = 0;      //beginning of that slot.
+
+    if(L>0)                                  //Pour the events of a coarser
+    { s = WS*L+b; h = Wh[s]; Wh[s] = 0;      //slot down onto the finer wheels.
+      Wm[L][b/64] &= ~((wbits)1<<(b%64));
+      for(j=h; j; j=jn)
+      { jn = WN[j]; WPush(WSlot(WK[j]), j); } } }
+
+  return 0;                                  //Signal when no events remain.
+}
+
+/*----------------------------------------------------------------------------*
+WHEEL SERVICE ROUTINES
+
+'WSlot' finds the slot for tick 'k', 'WPush' adds event 'n' to the front of
+slot 's', 'WDrop' removes it from its slot, and 'WScan' finds the first occupied
+slot of wheel 'L' after slot 'b', or -1 if there is none.
+*/
+
+static int WSlot(long long k)
+{ long long d; int L;
+
+  if(k<Wt) k = Wt;                           //(Cannot happen, but be safe.)
+  for(L=0,d=(k^Wt)>>WB; d; L++,d>>=WB);      //Find the highest differing byte.
+  return WS*L + ((k>>(WB*L))&(WS-1));
+}
+
+static int WPush(int s, int n)
+{
+  WN[n] = Wh[s]; WP[n] = 0; WX[n] = s+1;
+  if(Wh[s]) WP[Wh[s]] = n;
+  Wh[s] = n;
+  Wm[s/WS][(s%WS)/64] |= (wbits)1<<(s%64);
+  if(s==(Wt&(WS-1))) Wo = 0;                 //Mark the present slot unsorted.
+  return 0;
+}
+
+static int WDrop(int n)
+{ int s;
+
+  s = WX[n]-1;
+  if(WP[n]) WN[WP[n]] = WN[n]; else Wh[s] = WN[n];
+  if(WN[n]) WP[WN[n]] = WP[n];
+  WX[n] = 0;
+  if(Wh[s]==0) Wm[s/WS][(s%WS)/64] &= ~((wbits)1<<(s%64));
+  return s;
+}
+
+static int WScan(int L, int b)
+{ int i; wbits w;
+
+  for(i=b+1; i<WS; i=(i/64+1)*64)            //Look at the rest of each word of
+  { w = Wm[L][i/64]>>(i%64);                 //the bitmap in turn.
+    if(w==0) continue;
+#ifdef __GNUC__
+    return i+__builtin_ctzll(w);
+#else
+    for(; (w&1)==0; w>>=1,i++);
+    return i;
+#endif
+  }
+  return -1;
+}
+
+/*----------------------------------------------------------------------------*
+DISPLAY PROFILE OF THE WHEELS
+
+EXIT:  A line describing the wheels has been displayed.
+       'WheelProfile' contains the amount of memory allocated for them.
+*/
+
+int WheelProfile(char *label)
+{ int L, s, c[WL];
+
+  for(L=0; L<WL; L++)                        //Count the occupied slots of
+  for(c[L]=s=0; s<WS; s++)                   //each wheel.
+    if(Wh[WS*L+s]) c[L] += 1;
+
+  printf("%s wheels of %d events, tick %g, occupied slots", label, We, 1/WQ);
+  for(L=0; L<WL; L++) printf(" %d", c[L]);
+  printf(".\n");
+  return PN*(sizeof(dec)+sizeof(long long)+3*sizeof(int)) + sizeof Wh;
+}
+
+
+/*============================================================================*
+SORT A LIST BY TIME
+
+This is a plain recursive merge sort, as described in 'sort.c', but comparing
+the times directly rather than through an ordering function supplied by the
+caller.
+
+ENTRY: 'nx' points to the forward links of the list. 'nx[0]' is unused.
+       'tm' points to the times of the elements.
+       'p' indexes the first element of the list, which ends with a zero.
+       'n' contains the number of elements, or zero if it is to be counted.
+
+EXIT:  'LSort' indexes the first element of the list, now in order of time.
+         Equal times keep their original order.
+*/
+
+static int LSort(int *nx, dec *tm, int p, int n)
+{ int q, h, i;
+
+  if(n==0) for(q=p; q; q=nx[q]) n++;        //Count the elements if necessary.
+  if(n<=1) { if(p) nx[p] = 0; return p; }
+
+  for(q=p,i=1; i<n/2; i++) q = nx[q];        //Split the list in half and sort
+  h = nx[q]; nx[q] = 0;                      //each half.
+  p = LSort(nx, tm, p, n/2);
+  q = LSort(nx, tm, h, n-n/2);
+
+  for(h=0; p&&q; h=nx[h])                    //Merge the two halves, using
+    if(tm[q]<tm[p]) { nx[h] = q; q = nx[q]; }//'nx[0]' to hold the head.
+    else            { nx[h] = p; p = nx[p]; }
+  nx[h] = p? p: q;
+  return nx[0];
+}
+
+
+/*----------------------------------------------------------------------------*
+ENLARGE AN ARRAY
+
+ENTRY: 'p' points to an array of 'm0' elements of 's' bytes each.
+       'm1' contains the number of elements wanted, more than 'm0'.
+
+EXIT:  'Grow' points to the array, reallocated with 'm1' elements, the new ones
+         cleared to zero.
+*/
+
+static void *Grow(void *p, int m0, int m1, int s)
+{
+  p = realloc(p, (size_t)m1*s); if(p==0) Error(911.);
+  memset((char*)p+(size_t)m0*s, 0, (size_t)(m1-m0)*s);
+  return p;
+}
+
+/* October 2026 [AGT]. */
@@ -0,0 +1,144 @@
+/*----------------------------------------------------------------------------*
+CHECK OF REDRAWN TIMES
+
+This program checks that drawing the times of mutation and transmission afresh,
+as 'REDRAW' in 'common.h' does, leaves the results of the model unchanged apart
+from the particular random numbers drawn. It runs the model built without
+'REDRAW' ('tb32n') and with it ('tb32r') over the same seeds, one after the
+other for each seed, and reads from the output of each run
+
+    the total of all case notifications, from the final table,
+    the total of the events counted in the reports, and
+    the final numbers in states U, I1, I2, and I3, and in disease (D1 to D6).
+
+For each of these it takes the mean over the seeds for each build and the
+standard error of that mean, and divides the difference of the two means by the
+standard error of the difference. If any of these exceeds the limit, the runs
+differ by more than chance allows and the check fails with error 748. With the
+default limit of 3 standard errors, a build that draws its times correctly
+fails by chance in only about one check in fifty, counting all seven measures.
+
+The program and both builds of the model are made with 'makerd', the model at
+1/25 scale, and run as
+
+    redraw [k] [z]
+
+where 'k' is the number of seeds, 1 to 'k' (default 30), and 'z' is the limit,
+in standard errors (default 3). Each run takes a few seconds. For each seed the
+program displays the notifications and events of each build, and at the end the
+mean of each measure for each build and their difference in standard errors.
+*/
+
+#include "common.h"
+
+#define RD_K    30         //Default number of seeds.
+#define RD_Z    3.         //Default limit, in standard errors.
+#define RD_M    7          //Measures compared.
+#define RD_F    26         //Fields in a report line, through 'Events'.
+#define RD_LINE 4096       //Longest line of output.
+
+static char *prog[] = { "tb32n", "tb32r" };  //Builds without and with 'REDRAW'.
+static char *name[RD_M] = { "Notifications", "Events", "U", "I1", "I2", "I3",
+  "Disease" };
+
+static int Run(int, int, dec[RD_M]), Fields(char*, dec*);
+
+int main(int argc, char *argv[])
+{ int i, j, k, s, iz; dec x[RD_M], m[2][RD_M], v[2][RD_M], e[2][RD_M];
+  dec zl, z, zm, ev;
+
+  k  = argc>1? atoi(argv[1]): RD_K;          //Collect the size of the check.
+  zl = argc>2? atof(argv[2]): RD_Z;
+  if(k<2||zl<=0) Error2(525., "k=",k, " z=",zl);
+
+  for(ev=0, j=0; j<2; j++)                   //Clear the sums.
+  for(i=0; i<RD_M; i++) m[j][i] = v[j][i] = 0;
+
+  printf(" seed  notifications, without and with  events, without and with\n");
+  for(s=1; s<=k; s++)                        //Run each seed with each build
+  { for(j=0; j<2; j++)                       //and accumulate the measures.
+    { Run(j, s, x);
+      for(i=0; i<RD_M; i++)
+      { m[j][i] += x[i]; v[j][i] += x[i]*x[i]; }
+      if(j==0) { printf("%5d %16.0f", s, x[0]); ev = x[1]; }
+      else printf("%16.0f %18.0f %16.0f\n", x[0], ev, x[1]); }
+    fflush(stdout); }
+
+  for(j=0; j<2; j++)                         //Find the means and the standard
+  for(i=0; i<RD_M; i++)                      //errors of the means.
+  { m[j][i] /= k;
+    v[j][i] = (v[j][i]-k*m[j][i]*m[j][i])/(k-1);
+    e[j][i] = v[j][i]>0? sqrt(v[j][i]/k): 0; }
+
+  printf("\nmeasure           without          with     z\n");
+  for(zm=0, iz=i=0; i<RD_M; i++)             //Compare the means of each
+  { z = sqrt(e[0][i]*e[0][i]+e[1][i]*e[1][i]);  //measure.
+    z = z>0? (m[1][i]-m[0][i])/z: m[1][i]==m[0][i]? 0: 1e9;
+    printf("%-13s %13.1f %13.1f %5.2f\n", name[i], m[0][i], m[1][i], z);
+    if(fabs(z)>zm) { zm = fabs(z); iz = i; } }
+
+  if(zm>zl) Error2(748., "measure=",iz+1, " z=",zm);
+  printf("All measures within %g standard errors over %d seeds.\n", zl, k);
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+RUN THE MODEL ONCE
+
+ENTRY: 'j' is 0 for the build without 'REDRAW' and 1 for the build with it.
+       's' is the seed.
+
+EXIT:  'x' contains the measures of the run, in the order of 'name'.
+*/
+
+static int Run(int j, int s, dec x[RD_M])
+{ int i, c, n; char cmd[64], line[RD_LINE], *p; dec f[RD_LINE/2];
+  FILE *fp;
+
+  sprintf(cmd, "./%s randseq=%d 2>/dev/null", prog[j], s);
+  fp = popen(cmd, "r");
+  if(fp==0) Error2(510., prog[j],0, " randseq=",s);
+
+  for(i=0; i<RD_M; i++) x[i] = 0;
+  for(c=n=0; fgets(line, sizeof line, fp); )
+  { if(strncmp(line, "Printing all case notifications", 31)==0) c = 1;
+    else if(line[0]!='|') continue;
+
+    else if(c)                               //Add up the case notifications.
+      for(p=line; *p=='|'; )
+      { x[0] += strtod(p+1, &p);
+        while(*p==' ') p++; }
+
+    else if(Fields(line, f)>=RD_F)           //Add up the events in each report
+    { x[1] += f[25];                         //and keep the final state.
+      x[2] = f[13]; x[3] = f[15]; x[4] = f[16]; x[5] = f[17];
+      for(x[6]=0, i=18; i<24; i++) x[6] += f[i];
+      n++; } }
+
+  if(pclose(fp)!=0||c==0||n==0)              //Make sure the run finished.
+    Error2(536., prog[j],0, " randseq=",s);
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+READ THE FIELDS OF A LINE
+
+ENTRY: 'line' holds numbers each preceded by '|'.
+
+EXIT:  'f' contains the numbers, up to the first field that is not a number.
+       'Fields' contains how many there are.
+*/
+
+static int Fields(char *line, dec *f)
+{ int n; char *p, *q;
+
+  for(n=0, p=line; *p=='|'; n++)
+  { f[n] = strtod(p+1, &q);
+    if(q==p+1) break;
+    for(p=q; *p==' '; p++); }
+  return n;
+}
+
+/* October 2026 [AGT]. */
@@ -106,8 +106,8 @@ things down. Here practice corresponds well with theory.
 As implemented in this module, The bins need not correspond to standard time
 units such as a minutes. The bin representing the current time is kept sorted so
 that each event to be dispatched need only be picked from the front of the list.
-That means that any time a new event is added to the current bin, that bin must
-be resorted.
+That means that any time a new event is added to the current bin, it must be
+placed in order among the others.
 
 In this module the three functions that correspond to the above are
 'EventSchedule', 'EventCancel,' and 'EventNext'.  They work essentially as
@@ -119,18 +119,18 @@ described above.
 DATA STRUCTURES
 
 The module has two main data structures, a circular series of time bins 'Q[h]',
-which index one event scheduled for the time slots 'h' represented by each bin,
-and a series of singly linked lists 'P[i]', which define the earliest event for
-each individual, linked to their proper time slots. Note that each bin 'Q[h]'
-represents many related time slots, all equal modulo the width of the series of
-time bins, 'Qw', described further below.
-
-The number of links 'P[i]' must be equal to the number of individuals, and is
-indexed by individual number. but the number of time bins 'Q[h]' may be smaller
-or larger than the number of individuals. The size of 'Q' is a matter of
-optimization. It is typical to have one time bin for each event that could be
-scheduled, meaning each bin will represent a single event on average. That is
-optimal if all bin operations are of equal speed.
+which hold the events scheduled for the time slots 'h' represented by each bin,
+and a list 'B[i]', which records the bin holding the pending event for each
+individual. Note that each bin 'Q[h]' represents many related time slots, all
+equal modulo the width of the series of time bins, 'Qw', described further
+below.
+
+The list 'B' must be as long as the number of individuals, and is indexed by
+individual number, but the number of time bins 'Q[h]' may be smaller or larger
+than the number of individuals. The size of 'Q' is a matter of optimization. It
+is typical to have one time bin for each event that could be scheduled, meaning
+each bin will represent a single event on average. That is optimal if all bin
+operations are of equal speed.
 
 The width 'Qw' of all bins combined is also a matter of optimization. If it is
 much too large, events will tend to cluster near the bin being dispatched. If it
@@ -139,36 +139,284 @@ events that are for the more distant future, not immediate events. A suitable
 value for 'Qw' can be found by knowledge of the system being analysed, or by
 experimental trials to find a good speed of operation.
 
-The linked lists of events in 'P' are not maintained in any particular order,
-for speed of addition, but before a bin is dispatched, it is sorted into order
-by event times, for speed of dispatching.
+Rather than fixing 'Qn' and 'Qw' in advance, this module tunes them as it runs,
+in the manner of a resizing calendar queue. The number of bins is doubled when
+the number of pending events 'Qe' grows past twice the number of bins, and
+halved when it falls below half, so there is always about one pending event per
+bin. The width is set from the rate at which events are actually being
+dispatched, so that about 'QF' events come due as each bin is passed. When
+either drifts by more than a factor of two the bins are rebuilt, which takes one
+pass through the pending events. The same program thus runs near one event per
+bin for a population of five million or fifty-five million without being
+recompiled.
+
+Each bin is a block of one 64-byte cache line holding the times and numbers of
+up to 'QE' events side by side, so that the events of a bin are examined
+without reaching out into arrays indexed by event number. A bin with more
+events than that continues in overflow blocks drawn from 'V' and chained from
+the first. The events of a bin are not maintained in any particular order, for
+speed of addition and removal. When the dispatcher reaches a bin, the events in
+it that belong to the present cycle are moved to the list 'R' and sorted into
+order by time, for speed of dispatching. Events scheduled for the immediate
+bin after that are inserted directly into their places in 'R'.
+
+The bin into which each event was placed is recorded in 'B', so that an event
+being cancelled is found by scanning only that bin. With the bins tuned to hold
+about one event each, the scan ordinarily looks at a single block.
+
+When 'QTICK' is defined, as it is below, times are held inside the module as
+64-bit integer "ticks" counted from the starting time, 2^42 ticks to a unit of
+time. The width of a bin is then a power of two ticks, and the bin number is
+found with a shift and a mask instead of a floating point division. Times
+passed in and out of the module remain in floating point. For times between
+1024 and 2048, which includes all calendar years of interest, a tick is exactly
+the precision of a double, so converting to ticks and back loses nothing and the
+order of events is precisely what it would be in floating point. Other times
+are rounded down to the nearest tick. Times more than about a million units
+beyond the start are all held at the same, largest tick.
+
+Many events in a simulation are scheduled for times after it will have ended:
+deaths decades ahead, for example, or progression to disease that never comes.
+When the caller declares the end of the simulation with 'EventHorizon', events
+beyond it are not placed in the bins at all but 'parked', marked in 'B' with
+their times in 'T' and counted in 'Qp', so they are never sorted or passed over
+in cycling through the bins. A parked event is touched again only if it is
+cancelled, rescheduled, or renumbered. If the bins run empty while events remain
+parked, 'EventNext' dispatches the earliest of those, so the caller sees time
+pass the horizon just as it would without parking. Should the caller go on
+dispatching past the horizon, the parked events are sorted once into the list
+'Pl' and dispatched from it in order.
+
+The number of events that may be pending, and so the size of 'T' and 'B', is
+not fixed when the module is compiled. The caller declares the highest event
+number it will use with 'EventSize', before scheduling or at any time later, and
+the arrays are enlarged to suit, keeping the events already scheduled. Until
+then enough is provided for 'PMIN' events, so a small run pays only for what it
+uses, and 'EventInit' clears only that much.
+
+A caller that reorders its own records, so that those reached together lie
+together in memory, must have the events renumbered to match. 'EventTimes'
+gives the times of all the events in a range of numbers, from which the caller
+may choose the new order, and 'EventPermute' renumbers all of them at once, in
+a single pass over the bins, rather than one by one through 'EventRenumber'.
+
+The calendar queue is not the only queue available. 'EventType' may be called
+before any events are scheduled to select instead a four-way heap, a ladder
+queue, or a hierarchical timing wheel, all in 'queues.c'. The entry points of
+this module then check their arguments as usual and pass the work to the queue
+selected, keeping only the count of pending events here.
+
+When a large number of events are to be scheduled at once, as in constructing
+an initial population, placing them one by one in the bins is slower than it
+need be: the bins are rebuilt repeatedly as they double in number, and each
+event lands in a bin far from the last, so nearly every placement misses the
+cache. Moreover the caller may change its mind about an event several times
+before the population is complete. Between 'EventLoad(1)' and 'EventLoad(0)',
+therefore, events scheduled are merely 'held', marked in 'B' with their times
+in 'T', and cancelling or rescheduling them changes only those marks. When
+holding ends, the bins are enlarged once to their final number and the held
+events are placed in them in order of bin, found by counting the events for
+each bin, so the bins are filled from first to last. 'EventBulkLoad' does the
+same for a list of events supplied all at once.
+
+This module keeps its state in static variables and is to be called from one
+thread at a time. Where several threads must schedule, cancel, and dispatch
+events at once, the separate queue in 'qconc.c' serves instead.
+
+So that changes to the scheduler can be measured on the work of an actual run
+rather than on synthetic events, every call to the entry points of this module
+can be recorded in a file named with 'EventTrace'. Each record holds the
+operation, the event number, and the time, in the structure 'Qtrc' below. The
+program 'qreplay.c' feeds such a file back through the same entry points, with
+no other part of the model involved.
 */
 
 #include "common.h"
 
 #define PINIT  if(run1==0) EventInit();
-
-#define PEMPTY -1      //Marker for bins containing no linkages.
-#define TN (INDIV+0)   //Maximum number of time bins.
-#define PN (INDIV+3)   //Maximum number of time bin forward indexes.
-#define TW  20         //Time width of all bins combined (for optimization).
+#define QTICK          //Keep times in integer ticks (comment out for floating).
+#define QHUGE          //Ask for huge pages for large arrays (comment out for not).
+#define QPAR  4        //Threads sorting the largest bins (comment out for one).
+
+#define PEMPTY -1      //Marker for events not scheduled.
+#define PPARK  -2      //Marker for events parked beyond the horizon.
+#define PLOAD  -3      //Marker for events held to be loaded together.
+#define PMOVE  -4      //Marker for numbers not yet reached in renumbering.
+#define PMIN 1024      //Event numbers provided for at first.
+#define TW  20         //Initial time width of all bins combined.
+#define QMIN 1024      //Fewest time bins, a power of two.
+#define QF  1.0        //Events to come due per bin (for optimization).
+#define QS  65536      //Events dispatched between checks of the width.
+#define QK  4398046511104.0  //Ticks per unit of time, 2^42.
+#define QM  1048576.0        //Latest time representable in ticks, 2^20.
+#define QE  4          //Events held in each block of a bin.
+#define QV  1024       //Overflow blocks allocated at first.
+#define QI  16         //Longest list sorted by simple insertion.
+#define QR  2048       //Shortest list sorted by radix.
+#define QRP 1048576    //Shortest list sorted by radix in several threads.
+#define QHP 2097152    //Size of a huge page, in bytes.
+
+#if defined(QHUGE) && defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#ifdef QPAR
+#include <pthread.h>
+#endif
+
+#ifdef QTICK
+typedef long long qkey;   //Times within the module, in ticks.
+#else
+typedef dec qkey;         //Times within the module, unconverted.
+#endif
+
+struct Qblk            //STRUCTURE OF EACH BLOCK OF A BIN                  BYTES
+{ qkey t[QE];          //Times of the events                                 32
+  int  n[QE];          //Numbers of the events                               16
+  int  c;              //Number of events in the block                        4
+  int  x;              //Next block of the bin in 'V', or zero                4
+  int  u[2];           //Unused (pads the block to a cache line)              8
+};                     //                                                    64
+
+struct Qent            //STRUCTURE OF EACH ENTRY IN THE IMMEDIATE LIST     BYTES
+{ qkey t;              //Time of the event                                    8
+  int  n;              //Number of the event                                  4
+  int  u;              //Unused (pads the entry to 16 bytes)                  4
+};
+
+struct Qtrc            //STRUCTURE OF EACH TRACE RECORD                    BYTES
+{ dec  t;              //Time, or the old number for 'EventRenumber'          8
+  int  n;              //Number of the event, or the argument                 4
+  int  op;             //Operation (see 'EventTrace')                         4
+};
+
+struct Qrdx            //STRUCTURE OF EACH THREAD'S PART OF A RADIX PASS   BYTES
+{ struct Qent *x, *y;  //Entries to be moved and the area receiving them     16
+  unsigned long long lo; //Earliest time in the list, as sorted               8
+  int  a, b;           //First entry of the part and the one after the last   8
+  int  d;              //Lowest bit of the byte sorted on                     4
+  int  cnt[256];       //Count, then next position, for each value of it   1024
+  int  u[7];           //Unused (pads the part to 17 cache lines)            28
+};                     //                                                  1088
 
 dec t;                 //Current time, last dispatched event.
 
 static int run1;       //Flag to detect if the routine is being reused.
 
-static dec T[PN];      //Time for each scheduled event.
-static int P[PN];      //Forward indexes within bins, ending with zero.
-static int Q[TN];      //First index for the bin, with zero for empty bins.
-
-static int Qn  = TN;   //Number of elements in 'Q'.
+static qkey *T;        //Time for each parked event.
+static int *B;         //Bin holding each event, or 'PEMPTY', 'PPARK', or
+                       //'PLOAD'.
+static int Pn  = 0;    //Number of elements in 'T' and 'B'.
+static struct Qblk *Q; //First block of each bin, aligned on a cache line.
+static void *Qm;       //Memory allocated for 'Q'.
+static struct Qblk *V; //Overflow blocks, with 'V[0]' unused.
+static int Vn = 0;     //Number of blocks allocated in 'V'.
+static int Vu = 0;     //Number of blocks in 'V' ever used.
+static int Vf = 0;     //First released block in 'V', or zero.
+static struct Qent *R; //Events of the immediate bin in order of time.
+static struct Qent *S; //Work area for sorting 'R'.
+#ifdef QPAR
+static struct Qrdx Rp[QPAR]  //Each thread's part of a radix pass, aligned on
+  __attribute__((aligned(64))); //a cache line.
+#endif
+static int Ra = 0;     //Number of entries allocated in 'R' and 'S'.
+static int Rh = 0;     //First entry in 'R' not yet dispatched.
+static int Rc = 0;     //Entries in 'R', including those dispatched.
+static struct Qent *Pl;//Parked events in order of time, once dispatching has
+                       //passed the horizon.
+static int Pla = 0;    //Number of entries allocated in 'Pl'.
+static int Plh = 0;    //First entry in 'Pl' not yet dispatched.
+static int Plc = 0;    //Entries in 'Pl', including those dispatched.
+static int Qpo = 0;    //Flag set while parked events are dispatched from 'Pl'.
+
+static int Qn  = QMIN; //Number of elements in 'Q'.
 static dec Qw  = TW;   //Interval of time represented for each cycle in 'Q'.
 static int Qi  = 0;    //Index of the immediate time bin.
-static int Qo  = 1;    //Flag set if the immediate bin is in order.
+static int Qo  = 0;    //Flag set if the immediate bin has been moved to 'R'.
 static int Qe  = 0;    //Number of events in all bins.
 
-static dec Qt0 = 0;    //Earliest time representable this cycle in 'Q'.
-static dec Qt1 = TW;   //Earliest time beyond this cycle in 'Q'.
+static qkey Qt0 = 0;   //Earliest time representable this cycle in 'Q'.
+static qkey Qt1 = 0;   //Earliest time beyond this cycle in 'Q'.
+static dec Qb  = 0;    //Time from which ticks are counted.
+static dec Qh  = 1e300;//Horizon beyond which events are parked.
+static int Qp  = 0;    //Number of events parked.
+static int Qpj = 0;    //Earliest parked event, or zero if not known.
+static int Qs  = 0;    //Width of each bin as a power of two ticks.
+static int Qg  = 0;    //Flag set while events are being held for loading.
+static int Qgn = 0;    //Number of events held.
+static int Qgh = 0;    //Highest number of any event held.
+
+static int Qd  = 0;    //Events dispatched since the width was last checked.
+static dec Qtd = 0;    //Time at which the width was last checked.
+static dec Qr  = 0;    //Measured events dispatched per unit time.
+static int Qz  = 0;    //Number of times the bins have been rebuilt.
+static dec Qx  = 0;    //Total number of events dispatched.
+static clock_t Qc;     //Processor time when dispatching began.
+
+static dec Qsn = 0;    //Bins sorted since statistics were last taken.
+static dec Qsl = 0;    //Total events in those bins.
+static dec Qfn = 0;    //Events searched for in their bins.
+static dec Qfl = 0;    //Total steps taken in those searches.
+static dec Qk  = 0;    //Empty bins passed over.
+static dec Qy  = 0;    //Cycles completed through the bins.
+
+static int Qtype = 0;  //Kind of event queue in use (see 'EventType').
+static FILE *Qtf = 0;  //File receiving the trace, or zero.
+
+static int Tune(), Resize(int, dec), Width(dec), Cycle(), Alloc(), Block();
+static int Bin(int, qkey), Put(int, qkey), Drop(int), Park(int), Beyond();
+static int List(), Enlist(int), PRoom(int), PCmp(const void*, const void*);
+static int Place(int, dec), Hold(int), Load(), Next(), Trace(int, int, dec);
+static int Take(int), Ready(int, qkey), Seek(int), Unready(int);
+static int Room(int), Sort(int, int), Radix(int, int), Huge(void*, size_t);
+static int Size(int), Shuffle(int*, int, int);
+#ifdef QPAR
+static int RSplit(struct Qent*, struct Qent*, int, unsigned long long, int);
+static int RRun(void *(*)(void*));
+static void *RCount(void*), *RMove(void*);
+#endif
+static struct Qblk *Find(int, int*);
+
+#define QCAL    0      //Kinds of event queue: the calendar queue here, or the
+#define QHEAP   1      //four-way heap, ladder queue, or timing wheel in
+#define QLADDER 2      //'queues.c'.
+#define QWHEEL  3
+
+#define QPASS(f,a) (Qtype==QHEAP? Heap##f a: Qtype==QLADDER? Ladder##f a: \
+                    Wheel##f a)
+
+int HeapInit(int), HeapStart(dec), HeapSchedule(int, dec), HeapCancel(int),
+    HeapReschedule(int, dec), HeapRenumber(int, int), HeapNext(),
+    HeapProfile(char*), HeapSize(int), HeapTime(int, dec*);
+int LadderInit(int), LadderStart(dec), LadderSchedule(int, dec),
+    LadderCancel(int), LadderReschedule(int, dec), LadderRenumber(int, int),
+    LadderNext(), LadderProfile(char*), LadderSize(int), LadderTime(int, dec*);
+int WheelInit(int), WheelStart(dec), WheelSchedule(int, dec), WheelCancel(int),
+    WheelReschedule(int, dec), WheelRenumber(int, int), WheelNext(),
+    WheelProfile(char*), WheelSize(int), WheelTime(int, dec*);
+
+#ifdef QTICK
+#define KEY(te) ((te)-Qb<QM? (qkey)(((te)-Qb)*QK): (qkey)(QM*QK))
+#define TIME(k) (Qb+(k)*(1/QK))
+#define QSPAN   ((qkey)Qn<<Qs)
+#define QBIN(k,i) { i = ((k)>>Qs) & (Qn-1); }
+#else
+#define KEY(te) (te)
+#define TIME(k) (k)
+#define QSPAN   Qw
+#define QBIN(te,i) { dec tr = ((te)-Qt0)/Qw;  /*Convert a time to a bin number,*/\
+  tr -= (long)tr; i = tr*Qn; }                /*modulo the cycle duration.   */
+#endif
+
+#define QNOW(i,k) ((i)==Qi && Qo && (k)<Qt1)  //Event belongs in 'R'.
+#define TRACE(op,n,te) { if(Qtf) Trace(op, n, te); } //Record an operation.
+
+#ifdef QTICK
+#define RKEY(k) ((unsigned long long)(k))       //Times as unsigned integers in
+#else                                           //the same order, for sorting
+#define RKEY(k) RBits(k)                        //by radix.
+static unsigned long long RBits(dec);
+#endif
 
 /*----------------------------------------------------------------------------*
 INITIALIZE STATIC DATA STRUCTURES
@@ -186,17 +434,23 @@ EXIT:  Any prior data have been wiped clean.
 EventInit()
 { int i;
 
-  for(i=0; i<PN; i++) P[i] = PEMPTY;
+  if(Qtype) { QPASS(Init, (0)); Qtype = QCAL; }  //Release any other queue.
+  if(Pn==0) EventSize(PMIN-1);
+  for(i=0; i<Pn; i++) B[i] = PEMPTY;
+  free(Qm); free(V);
+  Qn = QMIN; Alloc();
+  Qb = t = 0; Rh = Rc = 0;
+  Width(TW); Cycle();
   if(run1==0) { run1 = 1; return; }
 
-  for(i=0; i<PN; i++) T[i] = 0;
-  for(i=0; i<TN; i++) Q[i] = 0;
+  for(i=0; i<Pn; i++) T[i] = 0;
 
-  Qn  = TN; Qw  = TW; Qi  = 0;
-  Qo  = 1;  Qe  = 0;
-  Qt0 = 0;  Qt1 = TW;
-
-  t = 0;
+  Qe  = 0;
+  Qh  = 1e300; Qp = 0; Qpj = 0;
+  Qpo = 0;    Plh = 0;  Plc = 0;
+  Qg  = 0;    Qgn = 0;  Qgh = 0;
+  Qd  = 0;    Qtd = 0;  Qr = 0; Qz = 0; Qx = 0;
+  Qsn = Qsl = Qfn = Qfl = Qk = Qy = 0;
 }
 
 
@@ -217,13 +471,14 @@ EXIT:  't' is set to the 't0'.
 
 EventStartTime(dec t0)
 { PINIT;                                     //Initialize if necessary.
+  TRACE('T', 0, t0);                         //Record it if tracing.
 
-  if(Qe) Error(742.);                        //Make sure the bins are empty.
-
-  Qt0 = t0-(Qw/Qn)/2;                        //Set the time boundaries, leaving
-  Qt1 = Qt0+Qw;                              //room for rounding errors.
+  if(Qe||Qp||Qgn) Error(742.);              //Make sure the bins are empty.
 
-  t = t0;                                    //Set the global time.
+  t = Qtd = Qb = t0;                         //Set the global time and the
+  Cycle();                                   //time boundaries, and note the
+  Qc = clock();                              //processor time.
+  if(Qtype) QPASS(Start, (t0));              //Start any other queue as well.
 }
 
 /*
@@ -233,108 +488,372 @@ starting time was set precisely to the year 1960, but an independent
 calculation somewhere generated the first event as 1959.9999999999, or
 equivalent in some other radix. Then the event would not be slotted in the
 first bin, but rather in the last, and would not come out of the list in
-proper order. Positioning it in the middle prevents that.
+proper order. Positioning it in the middle prevents that. When times are kept
+in ticks the bins are instead aligned on exact tick boundaries, and the problem
+does not arise.
+*/
+
+
+/*----------------------------------------------------------------------------*
+SELECT KIND OF QUEUE
+
+ENTRY: 'k' contains the kind of event queue to use: 0 for the calendar queue in
+         this module, 1 for a four-way heap, 2 for a ladder queue, or 3 for a
+         hierarchical timing wheel.
+       No events are scheduled.
+
+EXIT:  Subsequent calls to this module use the queue selected, starting at the
+         current time.
 */
 
+EventType(int k)
+{ PINIT;                                     //Initialize if necessary.
+  TRACE('Y', k, 0);                          //Record it if tracing.
+
+  if(k<QCAL||k>QWHEEL) Error1(743., "k=",k); //Make sure the kind is known and
+  if(Qe||Qp||Qgn) Error(742.);              //the queue is empty.
+  if(k==Qtype) return;
+
+  if(Qtype) QPASS(Init, (0));                //Release the queue in use and
+  Qtype = k;                                 //start the new one.
+  if(Qtype) QPASS(Init, (Pn));
+}
+
+
+/*----------------------------------------------------------------------------*
+PROVIDE FOR MORE EVENTS
+
+This routine enlarges the range of event numbers that may be scheduled. It may
+be called at any time, with events pending or not, in whatever queue is in use.
+The range is never reduced.
+
+ENTRY: 'm' contains the highest event number that will be used.
+
+EXIT:  Events numbered 1 through 'm' may be scheduled. Any events already
+         scheduled are unaffected.
+*/
+
+EventSize(int m)
+{
+  TRACE('Z', m, 0);                          //Record it if tracing.
+  Size(m);
+}
+
+static int Size(int m)
+{ int i;
+
+  if(m<Pn) return 0;                         //Return if there is room already.
+
+  T = (qkey*)realloc(T, (size_t)(m+1)*sizeof(qkey));
+  B = (int*) realloc(B, (size_t)(m+1)*sizeof(int));
+  if(T==0||B==0) Error(911.);                //Enlarge the arrays, asking for
+  Huge(T, (size_t)(m+1)*sizeof(qkey));       //huge pages, and mark the new
+  Huge(B, (size_t)(m+1)*sizeof(int));        //events unscheduled. ('T' is
+  for(i=Pn; i<=m; i++) B[i] = PEMPTY;        //read only for events marked in
+  if(Qtype) QPASS(Size, (m+1));              //'B'.)
+  Pn = m+1; return 0;
+}
+
 
 /*----------------------------------------------------------------------------*
 SCHEDULE NEW EVENT
 
 ENTRY: 'n' contains the number (starting with 1) of a new event.
        'te' contains the time at which the event will occur.
-       'P[n]' indicates that the event is unscheduled (equal to 'PEMPTY').
+       'B[n]' indicates that the event is unscheduled (equal to 'PEMPTY').
 
 EXIT:  The event has been scheduled, to occur when the proper time arrives.
-       'T[n]' records the time 'te' of the event.
-       'P[n]' links the event with others in its time bin.
+       'B[n]' records the number of its bin, or that it is parked or held.
 
 WORK:  The scheduling data structures are prepared as described above.
 */
 
 EventSchedule(int n, dec te)
-{ int i; dec tr;
-
+{
   PINIT;                                     //Initialize if necessary.
+  TRACE('S', n, te);                         //Record it if tracing.
 
-  if(n<1||n>=PN)   Error1(734.1, "n=",n);    //Check the index and make sure an
-  if(P[n]!=PEMPTY) Error1(735.1, "n=",n);    //event is not already scheduled
+  if(n<1||n>=Pn)   Error1(734.1, "n=",n);    //Check the index and pass the
+  if(Qtype) { QPASS(Schedule, (n,te));       //event to any other queue.
+              Qe += 1; return; }
+
+  if(B[n]!=PEMPTY) Error1(735.1, "n=",n);    //Make sure the event is not
+                                             //already scheduled
   if(te<t) Error2(737., "t=",t, ">",te);     //and is not in the past.
 
-  T[n] = te;                                 //Record the time of the new event.
+  Place(n, te);                              //Put the event in its bin.
+}
+
 
-  tr = (te-Qt0)/Qw; tr -= (int)tr;           //Convert the time to a bin number
-  i  = tr*Qn; if(i==Qi) Qo = 0;              //and mark for sorting if needed.
+/*----------------------------------------------------------------------------*
+PLACE, PARK, OR HOLD EVENT
+
+ENTRY: 'n' contains the number of an event in no bin, not parked, and not held.
+       'te' contains its time.
+
+EXIT:  The event is parked if it is beyond the horizon, held if events are
+         being held for loading, and otherwise placed in its bin.
+*/
 
-  P[n] = Q[i]; Q[i] = n;                     //Add the event to the list for
-  Qe += 1;                                   //that bin and increment the number
-}                                            //of events.
+static int Place(int n, dec te)
+{ qkey k;
+
+  k = KEY(te);
+  if(te>Qh)     { T[n] = k; Park(n); }
+  else if(Qg)   { T[n] = k; Hold(n); }
+  else          Bin(n, k);
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+PLACE EVENT IN ITS BIN
+
+ENTRY: 'n' contains the number of an event in no bin and not parked.
+       'k' contains its time.
+
+EXIT:  The event has been added to its bin, or to 'R' if that bin is the
+         immediate one and the event belongs to this cycle.
+       The event is counted in 'Qe'.
+*/
+
+static int Bin(int n, qkey k)
+{ int i;
+
+  QBIN(k, i);                                //Convert the time to a bin number
+  if(QNOW(i,k)) Ready(n, k);                 //and add the event to the bin, or
+  else          Put(n, k);                   //to its place in the immediate
+  Qe += 1;                                   //list, and count it.
+
+  if(Qe>2*Qn)                                //If the bins have become crowded,
+    Resize(2*Qn, Qr>0? QF*2*Qn/Qr: Qw);      //double their number.
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+PARK EVENT BEYOND THE HORIZON
+
+ENTRY: 'n' contains the number of an event in no bin and not parked.
+       'T[n]' contains its time, later than the horizon.
+
+EXIT:  The event is parked and counted in 'Qp'.
+       'Qpj' indexes the earliest parked event, if that is known.
+       The event has its place in 'Pl' if parked events are dispatched from it.
+*/
+
+static int Park(int n)
+{
+  B[n] = PPARK;                              //Mark the event parked and keep
+  if(Qp==0) Qpj = n;                         //track of the earliest.
+  else if(Qpj && T[n]<T[Qpj]) Qpj = n;
+  if(Qpo) Enlist(n);                         //Place it in the ordered list if
+  Qp += 1; return 0;                         //there is one.
+}
+
+
+/*----------------------------------------------------------------------------*
+HOLD EVENT FOR LOADING
+
+ENTRY: 'n' contains the number of an event in no bin, not parked, and not held.
+       'T[n]' contains its time, within the horizon.
+
+EXIT:  The event is held and counted in 'Qgn'.
+*/
+
+static int Hold(int n)
+{
+  B[n] = PLOAD; Qgn += 1;                    //Mark the event held and keep
+  if(Qgh<n) Qgh = n;                         //track of the highest.
+  return 0;
+}
 
 
 /*----------------------------------------------------------------------------*
 CANCEL EXISTING EVENT
 
 ENTRY: 'n' contains the number (starting with 1) of the event to be cancelled.
-       'T[n]' contains the scheduled time of the event.
 
-EXIT:  The event has been removed from the list.
+EXIT:  The event has been removed from its bin.
 
 WORK:  The scheduling data structures are prepared as described above.
 */
 
 EventCancel(int n)
-{ int i, j, jp; dec tr;
-
+{
   PINIT;                                     //Initialize if necessary.
+  TRACE('C', n, t);                          //Record it if tracing.
+
+  if(n<1||n>=Pn)   Error1(734.2, "n=",n);    //Check the index and pass the
+  if(Qtype) { QPASS(Cancel, (n));            //event to any other queue.
+              Qe -= 1; return; }
+
+  if(B[n]==PEMPTY) Error1(736.2, "n=",n);    //Make sure the event is scheduled.
+
+  if(B[n]==PPARK)                            //If the event is parked, simply
+  { B[n] = PEMPTY; Qp -= 1;                  //release it.
+    if(n==Qpj) Qpj = 0;
+    return; }
+  if(B[n]==PLOAD)                            //Likewise if it is held.
+  { B[n] = PEMPTY; Qgn -= 1;
+    return; }
+
+  if(B[n]!=Qi || Unready(n)==0) Drop(n);     //Remove the event from the
+  B[n] = PEMPTY;                             //immediate list or its bin.
+
+  Qe -= 1; if(Qe<0)                          //Decrement the number of events.
+    Error1(819., "n=",n);
+}
+
 
-  if(n<1||n>=PN)   Error1(734.2, "n=",n);    //Check the index and make sure an
-  if(P[n]==PEMPTY) Error1(736.2, "n=",n);    //event is scheduled.
+/*----------------------------------------------------------------------------*
+FIND EVENT IN ITS BIN
 
-  tr = (T[n]-Qt0)/Qw; tr -= (int)tr;         //Convert the time to a bin number,
-  i  = tr*Qn;                                //modulo the duration of the cycle.
+ENTRY: 'n' contains the number of a scheduled event.
+       'B[n]' contains the bin in which it was placed.
+       The event is not in the immediate list 'R'.
 
-  if(cancel1(n, i)) return;                  //Remove it from its normal bin.
+EXIT:  'Find' points to the block of the bin which holds the event.
+       's' contains the position of the event in that block.
+*/
 
-  i = (i-1+Qn) % Qn;                         //If it is not there, check the
-  if(cancel1(n, i)) return;                  //bin below (from rounding error).
+static struct Qblk *Find(int n, int *s)
+{ struct Qblk *b; int j;
 
-  i = (i+2+Qn) % Qn;                         //Finally, check the bin above.
-  if(cancel1(n, i)) return;
+  Qfn += 1;
+  for(b=&Q[B[n]]; ; b=&V[b->x])              //Scan the blocks of this bin for
+  { for(j=0; j<b->c; j++)                    //the event. (The average number of
+    { Qfl += 1;                              //events in a non-empty bin is 1.5)
+      if(b->n[j]==n) { *s = j; return b; } }
+    if(b->x==0) break; }
 
   Error1(818., "n=",n);                      //If the specified event was not in
-}                                            //the list, signal an error.
-
-int cancel1(int n, int i)
-{ int j, jp;
-
-  for(jp=0,j=Q[i]; j>0; jp=j,j=P[j])         //Scan the list of pending events
-    if(j==n)                                 //in this bin and remove the
-    { if(jp>0) P[jp] = P[j];                 //specified event. (The average
-      else     Q[i]  = P[j];                 //number events in a non-empty bin
-      P[j] = PEMPTY;                         //is 1.5)
-      Qe -= 1; if(Qe<0)
-        Error2(819., "n=",n, " bin=",i);
-      return 1; }
-  return 0;
+  return 0;                                  //the bin, signal an error.
 }
 
 /*
-Note: It is necessary to check not just the expected bin when an event is to be
-deleted, but the two adjacent bins as well if the event does not appear. This is
-because of the vagaries of finite-precision computer arithmetic. Two bins are
-separated by a knife-edge, and what is calculated one time as 1.0 may be
-calculated in a slightly different manner as 0.999999999999999, dropping it in
-an adjacent bin. In simulations testing this condition, it happened only once
-per ten million times or less, so there is no speed issue here, only a
-correctness issue.
+Note: Earlier versions recomputed the bin from the time of the event, and so had
+to check not just that bin but the two adjacent bins as well if the event did
+not appear. This was because of the vagaries of finite-precision computer
+arithmetic. Two bins are separated by a knife-edge, and what is calculated one
+time as 1.0 may be calculated in a slightly different manner as
+0.999999999999999, dropping it in an adjacent bin. Recording the bin when the
+event is scheduled removes the recomputation and the knife-edge with it.
+Integer ticks, when used, remove the knife-edge altogether.
+
+Earlier versions also linked the events of each bin through an array indexed by
+event number, with their times in another, so that every step through a bin
+and every comparison in sorting it reached into a different part of memory.
+Holding the times and numbers together in the blocks of the bin means a bin of
+a few events is usually examined in a single cache line.
 */
 
 
+/*----------------------------------------------------------------------------*
+ADD OR REMOVE EVENT IN BIN
+
+'Put' adds event 'n' with time 'k' to its bin. The first block of the bin is
+filled first. Beyond that, events go into the first overflow block, and when
+that is full a new overflow block is placed ahead of it, so every overflow block
+but the first is always full.
+
+'Drop' removes event 'n' from its bin, filling its place with the last event of
+the first overflow block, or of the first block if there is no overflow, and
+releasing an overflow block that becomes empty.
+*/
+
+static int Put(int n, qkey k)
+{ int i, v; struct Qblk *b;
+
+  QBIN(k, i); b = &Q[i];                     //Find the first block of the bin.
+  if(b->c>=QE)                               //If it is full, go to the first
+  { v = b->x;                                //overflow block, placing a new
+    if(v==0 || V[v].c>=QE)                   //one ahead of it if it is full
+    { v = Block(); V[v].x = b->x; b->x = v; }//too.
+    b = &V[v]; }
+
+  b->t[b->c] = k; b->n[b->c] = n;            //Add the event to the block and
+  b->c += 1; B[n] = i;                       //record its bin.
+  return 0;
+}
+
+static int Drop(int n)
+{ int s, v; struct Qblk *b, *d;
+
+  b = Find(n, &s);                           //Find the event and the block from
+  d = &Q[B[n]]; v = d->x;                    //which to fill its place.
+  if(v) d = &V[v];
+
+  d->c -= 1;                                 //Move the last event of that block
+  b->t[s] = d->t[d->c];                      //into the place of the one
+  b->n[s] = d->n[d->c];                      //removed.
+
+  if(v && d->c==0)                           //Release an overflow block that
+  { Q[B[n]].x = d->x;                        //has been emptied.
+    d->x = Vf; Vf = v; }
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+RESCHEDULE EXISTING EVENT
+
+This routine changes the time of an event already scheduled, in place of
+cancelling it and scheduling it anew. If the new time falls in the same bin the
+event stays where it is in the bin and only its time changes.
+
+ENTRY: 'n' contains the number of an event which is scheduled.
+       'te' contains the new time at which the event will occur.
+
+EXIT:  The event has been rescheduled to occur at time 'te'.
+*/
+
+EventReschedule(int n, dec te)
+{ int i, j, s; qkey k; struct Qblk *b;
+
+  PINIT;                                     //Initialize if necessary.
+  TRACE('R', n, te);                         //Record it if tracing.
+
+  if(n<1||n>=Pn)   Error1(734.5, "n=",n);    //Check the index and pass the
+  if(Qtype) { QPASS(Reschedule, (n,te));     //event to any other queue.
+              return; }
+
+  if(B[n]==PEMPTY) Error1(736.5, "n=",n);    //Make sure the event is scheduled
+  if(te<t) Error2(737.5, "t=",t, ">",te);    //and the new time is not past.
+
+  if(B[n]==PPARK)                            //If the event is parked, release
+  { B[n] = PEMPTY; Qp -= 1;                  //it and schedule it afresh.
+    if(n==Qpj) Qpj = 0;
+    Place(n, te);
+    return; }
+  if(B[n]==PLOAD)                            //Likewise if it is held.
+  { B[n] = PEMPTY; Qgn -= 1;
+    Place(n, te);
+    return; }
+
+  k = KEY(te); QBIN(k, i);                   //Convert the new time to a bin
+  j = B[n];                                  //number.
+
+  if(j!=Qi || Unready(n)==0)                 //Unless the event was in the
+  { if(i==j && !QNOW(i,k) && te<=Qh)         //immediate list, if its bin is
+    { b = Find(n, &s); b->t[s] = k;          //unchanged simply change its time.
+      return; }
+    Drop(n); }                               //Otherwise remove it from its bin
+
+  B[n] = PEMPTY; Qe -= 1;                    //and place it again, in a bin or
+  if(te>Qh) { T[n] = k; Park(n); }           //parked beyond the horizon.
+  else Bin(n, k);
+}
+
+
 /*----------------------------------------------------------------------------*
 RENUMBER EXISTING EVENT
 
 This routine renumbers events. It can be called, for example, to reuse an entry
 when it becomes available, for example from a simulated death, shifting an
-existing individual from the end of the array keep the array compact.
+existing individual from the end of the array keep the array compact. The new
+number takes the place of the old in its bin, so the time need not be converted
+again and a sorted bin remains sorted.
 
 ENTRY: 'n' contains the new index number, which has no event scheduled.
        'm' contains the current index number of the event.
@@ -346,21 +865,186 @@ EXIT:  'n' is the new index number of the individual.
 */
 
 EventRenumber(int n, int m)
-{
-  if(n<1||n>=PN) Error1(734.3, "n=",n);      //Check the indexes and make sure
-  if(m<1||m>=PN) Error1(734.4, "n=",m);      //they are in range.
+{ int j, s; struct Qblk *b;
+
+  PINIT;                                     //Initialize if necessary.
+  TRACE('N', n, m);                          //Record it if tracing.
+
+  if(n<1||n>=Pn) Error1(734.3, "n=",n);      //Check the indexes and make sure
+  if(m<1||m>=Pn) Error1(734.4, "n=",m);      //they are in range.
+  if(n==m) return;
+  if(Qtype) { QPASS(Renumber, (n,m));        //Pass the event to any other
+              return; }                      //queue.
+
+  if(B[m]==PEMPTY) Error1(736.3, "n=",m);    //Make sure 'm' is scheduled and
+  if(B[n]!=PEMPTY) Error1(735.3, "n=",n);    //'n' is not.
+
+  if(B[m]==PPARK)                            //A parked event needs only its
+  { B[n] = PPARK; T[n] = T[m];               //number changed.
+    B[m] = PEMPTY;
+    if(Qpj==m) Qpj = n;
+    if(Qpo) Enlist(n);
+    return; }
+  if(B[m]==PLOAD)                            //So does a held event.
+  { B[n] = PLOAD; T[n] = T[m];
+    B[m] = PEMPTY;
+    if(Qgh<n) Qgh = n;
+    return; }
+
+  B[n] = B[m];                               //Find the old number in the
+  if(B[m]==Qi && (j=Seek(m))>=0) R[j].n = n; //immediate list or its bin and put
+  else { b = Find(m, &s); b->n[s] = n; }     //the new number in its place, with
+  B[m] = PEMPTY;                             //the same time.
+}
+
+
+/*----------------------------------------------------------------------------*
+REPORT TIMES OF EVENTS
+
+This routine gives the times of all the events in a range of numbers at once,
+so that the caller can decide how they are to be renumbered by 'EventPermute'.
+The bins are passed over once from first to last, which is much faster than
+finding each event in its bin.
+
+ENTRY: 'w' points to an array of at least 'm' elements.
+       'n0' contains the first event number of the range and 'm' the number of
+         event numbers in it.
+
+EXIT:  'w[i]' contains the time of event 'n0+i', or 1e300 if it is not
+         scheduled.
+       'EventTimes' contains the number of events scheduled in the range.
+*/
+
+int EventTimes(dec w[], int n0, int m)
+{ int i, j, c; unsigned k; struct Qblk *b;
+
+  PINIT;                                     //Initialize if necessary.
+
+  if(n0<1||m<0||n0+m>Pn)                     //Check the range.
+    Error2(734.6, "n=",n0, " m=",m);
+  for(i=0; i<m; i++) w[i] = 1e300;
+
+  if(Qtype)                                  //Ask any other queue for each
+  { for(c=i=0; i<m; i++)                     //event.
+      c += QPASS(Time, (n0+i, &w[i]));
+    return c; }
+
+  for(c=i=0; i<Qn; i++)                      //Collect the times of the events
+  for(b=&Q[i]; ; b=&V[b->x])                 //in the range from every block of
+  { for(j=0; j<b->c; j++)                    //every bin,
+      if((k=b->n[j]-n0)<(unsigned)m)
+      { w[k] = TIME(b->t[j]); c += 1; }
+    if(b->x==0) break; }
+
+  for(j=Rh; j<Rc; j++)                       //from the immediate list,
+    if((k=R[j].n-n0)<(unsigned)m)
+    { w[k] = TIME(R[j].t); c += 1; }
+
+  if(Qp||Qgn)                                //and from the events parked or
+  for(i=0; i<m; i++)                         //held.
+    if(B[n0+i]==PPARK||B[n0+i]==PLOAD)
+    { w[i] = TIME(T[n0+i]); c += 1; }
+  return c;
+}
+
+
+/*----------------------------------------------------------------------------*
+RENUMBER EVENTS IN BULK
+
+This routine renumbers all the events in a range of numbers at once, so that a
+caller can reorder its own records by any rule it chooses and have the events
+follow. Done one by one with 'EventRenumber' that would need a free number to
+pass each event through and a search of a bin for each; here the marks and
+times in 'B' and 'T' are moved to their new places through a work area, and the
+new numbers are then put in a single pass over the bins. (Moving them in place,
+along each cycle of the renumbering, would save the work area but reach each
+place only after the last, at the full delay of memory.) Events keep their
+places in their bins, so a sorted bin remains sorted. It is recorded in a trace
+as a 'P' record followed by one 'p' record for each new number.
+
+ENTRY: 'v' points to an array of 'm' elements, in which 'v[i]' contains the new
+         number for the event numbered 'n0+i'. The new numbers are 'n0' through
+         'n0+m-1', each used once.
+       Numbers with no event scheduled may be included.
+
+EXIT:  The event that was numbered 'n0+i' is numbered 'v[i]', for each 'i'.
+       'v' is unchanged.
+*/
+
+EventPermute(int v[], int n0, int m)
+{ int i, j, k, *x; unsigned u; qkey *y; struct Qblk *b;
+
+  PINIT;                                     //Initialize if necessary.
+  TRACE('P', n0, m);                         //Record it if tracing.
+  if(Qtf) for(i=0; i<m; i++) Trace('p', v[i], 0);
+
+  if(n0<1||m<0||n0+m>Pn)                     //Check the range.
+    Error2(734.7, "n=",n0, " m=",m);
+
+  x = (int*) malloc((m+1)*sizeof(int));      //Move the mark and time of each
+  y = (qkey*)malloc((m+1)*sizeof(qkey));     //event to its new number in a
+  if(x==0||y==0) Error(911.);                //work area, making sure that
+  for(k=0; k<m; k++) x[k] = PMOVE;           //every number is used once, and
+  for(i=0; i<m; i++)                         //then back.
+  { k = v[i]-n0;
+    if(k<0||k>=m||x[k]!=PMOVE) Error2(745., "n=",n0+i, " v=",v[i]);
+    x[k] = B[n0+i]; y[k] = T[n0+i]; }
+  memcpy(B+n0, x, m*sizeof(int));
+  memcpy(T+n0, y, m*sizeof(qkey));
+  free(x); free(y);
+
+  if(Qtype) { Shuffle(v, n0, m); return; }   //Pass any other queue the work.
+
+  for(i=0; i<Qn; i++)                        //Put the new numbers in every
+  for(b=&Q[i]; ; b=&V[b->x])                 //block of every bin and in the
+  { for(j=0; j<b->c; j++)                    //immediate list.
+      if((u=b->n[j]-n0)<(unsigned)m) b->n[j] = v[u];
+    if(b->x==0) break; }
+  for(j=Rh; j<Rc; j++)
+    if((u=R[j].n-n0)<(unsigned)m) R[j].n = v[u];
+  for(j=Plh; j<Plc; j++)
+    if((u=Pl[j].n-n0)<(unsigned)m) Pl[j].n = v[u];
+
+  if(Qpj && (u=Qpj-n0)<(unsigned)m)          //Follow the earliest parked event
+    Qpj = v[u];                              //and the highest held.
+  if(Qgn && Qgh>=n0 && Qgh<n0+m-1) Qgh = n0+m-1;
+}
+
+/*
+'Shuffle' renumbers the events of any other queue, which keeps no marks in 'B'.
+Each event is exchanged with the one in the place it is going until every place
+holds its own, passing through a spare number beyond the range, provided if
+necessary by enlarging the range of event numbers.
+*/
+
+static int Shuffle(int v[], int n0, int m)
+{ int i, k, a, c, s, *x; dec w;
+
+  s = Pn-1;                                  //Find a spare number.
+  if(s<n0+m || QPASS(Time, (s, &w)))
+  { Size(Pn); s = Pn-1; }
+
+  x = (int*)malloc((m+1)*sizeof(int));       //Copy the new numbers.
+  if(x==0) Error(911.);
+  for(i=0; i<m; i++) x[i] = v[i];
 
-  if(n!=m)
-  { T[n] = T[m];                             //Transfer the time.
-    EventCancel(m);                          //Cancel the old number.
-    EventSchedule(n, T[n]); }                //Reschedule as the new number.
+  for(i=0; i<m; i++)                         //Exchange the event in each place
+  while((k=x[i]-n0)!=i)                      //with the one in the place it is
+  { a = QPASS(Time, (n0+i, &w));             //going, until it holds its own.
+    c = QPASS(Time, (n0+k, &w));
+    if(a) QPASS(Renumber, (s, n0+i));
+    if(c) QPASS(Renumber, (n0+i, n0+k));
+    if(a) QPASS(Renumber, (n0+k, s));
+    x[i] = x[k]; x[k] = n0+k; }
+
+  free(x); return 0;
 }
 
+
 /*----------------------------------------------------------------------------*
 LOCATE NEXT EVENT
 
-ENTRY: 'T' contains the time of the next event for every event scheduled.
-       The bin structure is properly initialized.
+ENTRY: The bin structure is properly initialized.
 
 EXIT:  'EventNext' contains the number of the next event. If zero, no events
          are scheduled.
@@ -370,26 +1054,42 @@ WORK:  The scheduling data structures are prepared as described above.
 */
 
 int EventNext()
-{ int j, n;
+{ int n;
 
   PINIT;                                     //Initialize if necessary.
 
-  while(Qe>0)
-  { for(; Qi<Qn; Qo=0,Qi++)                  //Advance to the next non-empty
-    { j = Q[Qi]; if(j==0) continue;          //bin.
+  n = Next();                                //Take the next event and record
+  TRACE('X', n, t);                          //it if tracing.
+  return n;
+}
 
-      if(Qo==0)                              //Sort the bin if it may be
-      { j = Q[Qi] = sort(P,j,0); Qo = 1; }   //necessary.
+static int Next()
+{ int n;
 
-      if(T[j]<Qt1)                           //If the event belongs to this
-      { if(P[j]==PEMPTY) Error(820.1);       //pass, remove it from the list,
-        Q[Qi] = P[j];                        //decrement the number of events,
-        P[j] = PEMPTY; Qe -= 1;              //advance the global time, and
-        t = T[j]; return j; } }              //return the event's index.
+  if(Qtype)                                  //Take the event from any other
+  { n = QPASS(Next, ());                     //queue.
+    if(n) { Qe -= 1; Qx += 1; }
+    return n; }
 
-    Qi = 0; Qt0 += Qw; Qt1 = Qt0+Qw; }       //Circle back to the first bin.
+  if(Qg) EventLoad(0);                       //Load any events held, and check
+  if(Qd>=QS) Tune();                         //the bins periodically.
 
-  return 0;                                  //Signal completion of all events.
+  while(Qe>0)
+  { if(Qo==0) { Take(Qi); Qo = 1; }          //Sort the immediate bin if that
+                                             //has not been done.
+    if(Rh<Rc)                                //If an event remains for this
+    { n = R[Rh].n; t = TIME(R[Rh].t);        //pass, remove it from the list,
+      Rh += 1; B[n] = PEMPTY;                //decrement the number of events,
+      Qe -= 1; Qd += 1; Qx += 1;             //advance the global time, and
+      return n; }                            //return the event's index.
+
+    Qo = 0;                                  //Otherwise advance to the next
+    if(++Qi>=Qn)                             //bin, circling back to the first
+    { Qi = 0; Qt0 = Qt1; Qt1 = Qt0+QSPAN;    //at the end of each cycle.
+      Qy += 1; } }
+
+  if(Qp>0) return Beyond();                  //Dispatch any parked events, then
+  return 0;                                  //signal completion of all events.
 }
 
 /*
@@ -402,6 +1102,817 @@ $n^2/2$, and the latter would be prohibitive.
 */
 
 
+/*----------------------------------------------------------------------------*
+SORT THE IMMEDIATE BIN
+
+ENTRY: 'i' contains the number of the immediate bin.
+       'Qt1' contains the end of the present cycle.
+       The immediate list 'R' has been exhausted.
+
+EXIT:  The events of the bin that belong to this cycle have been moved to 'R' in
+         order of time. 'Rh' indexes the first of them and 'Rc' follows the
+         last. The events of later cycles remain in the bin.
+*/
+
+static int Take(int i)
+{ int j, m, v, w; struct Qblk *b;
+
+  Rh = Rc = 0;
+  if(Q[i].c==0) { Qk += 1; return 0; }       //Pass over empty bins quickly.
+
+  for(b=&Q[i]; ; b=&V[b->x])                 //Copy every event in the bin to
+  { Room(Rc+QE);                             //the immediate list.
+    for(j=0; j<b->c; j++)
+    { R[Rc].t = b->t[j]; R[Rc].n = b->n[j]; Rc += 1; }
+    if(b->x==0) break; }
+
+  for(v=Q[i].x; v; v=w)                      //Empty the bin, releasing any
+  { w = V[v].x; V[v].x = Vf; Vf = v; }       //overflow blocks.
+  Q[i].c = Q[i].x = 0;
+
+  for(j=m=0; j<Rc; j++)                      //Keep the events of this cycle in
+    if(R[j].t<Qt1) R[m++] = R[j];            //the list and return the others to
+    else Put(R[j].n, R[j].t);                //the bin.
+  Rc = m;
+
+  if(m>1) Sort(0, m);                        //Sort the list, counting it for
+  Qsn += 1; Qsl += m;                        //the statistics.
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+MAINTAIN THE IMMEDIATE LIST
+
+'Ready' inserts event 'n' with time 'k' into its place in the immediate list,
+ahead of any events with the same time, as it would fall had it been added to
+the bin and the bin sorted again. 'Seek' returns the position of event 'n' in
+the list, or -1 if it is not there. 'Unready' removes event 'n' from the list
+if it is there, returning 1 if it was and 0 if not. 'Room' makes sure there is
+space for at least 'm' entries.
+*/
+
+static int Ready(int n, qkey k)
+{ int j;
+
+  Room(Rc+1);                                //Move later events up to make room
+  for(j=Rc; j>Rh && R[j-1].t>=k; j--)        //and insert the new one.
+    R[j] = R[j-1];
+  R[j].t = k; R[j].n = n; Rc += 1;
+  B[n] = Qi; return 0;
+}
+
+static int Seek(int n)
+{ int j;
+
+  for(j=Rh; j<Rc; j++) if(R[j].n==n) return j;
+  return -1;
+}
+
+static int Unready(int n)
+{ int j;
+
+  if(Qo==0 || (j=Seek(n))<0) return 0;       //Find the event and move earlier
+  for(; j>Rh; j--) R[j] = R[j-1];            //events up into its place.
+  Rh += 1; return 1;
+}
+
+static int Room(int m)
+{ int j;
+
+  if(m<=Ra) return 0;
+  if(Rh>0)                                   //Recover the space of events
+  { for(j=Rh; j<Rc; j++) R[j-Rh] = R[j];     //already dispatched if there is
+    Rc -= Rh; m -= Rh; Rh = 0;               //any.
+    if(m<=Ra) return 0; }
+
+  Ra = max(m, 2*Ra);                         //Otherwise allocate more.
+  R = (struct Qent*)realloc(R, Ra*sizeof(struct Qent));
+  S = (struct Qent*)realloc(S, Ra*sizeof(struct Qent));
+  if(R==0||S==0) Error(911.);
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+SORT LIST BY TIME
+
+Short lists, the usual case, are sorted by simple insertion. Longer ones are
+sorted by insertion in runs of 'QI' and the runs merged in pairs, alternating
+between 'R' and the work area 'S'. Comparisons are made directly on the times,
+which are beside the event numbers, so no other memory is touched. Lists of 'QR'
+or more, which arise only when many events crowd into one bin, are passed to
+'Radix'. Equal times keep their original order.
+
+ENTRY: 'h' indexes the first entry in 'R' to be sorted.
+       'c' follows the last.
+
+EXIT:  The entries are in order of time.
+*/
+
+static int Sort(int h, int c)
+{ int i, j, k, lo, mid, hi, w; struct Qent e, *x, *y, *z;
+
+  if(c-h>=QR) return Radix(h, c);            //Sort crowded bins by radix.
+
+  for(lo=h; lo<c; lo+=QI)                    //Sort each run by insertion.
+  for(hi=min(lo+QI,c),i=lo+1; i<hi; i++)
+  { e = R[i];
+    for(j=i; j>lo && R[j-1].t>e.t; j--) R[j] = R[j-1];
+    R[j] = e; }
+
+  x = R; y = S;
+  for(w=QI; w<c-h; w*=2)                     //Merge pairs of runs, doubling
+  { for(lo=h; lo<c; lo+=2*w)                 //their length each time.
+    { mid = min(lo+w, c); hi = min(lo+2*w, c);
+      for(i=lo,j=mid,k=lo; k<hi; k++)
+        y[k] = j>=hi || (i<mid && x[i].t<=x[j].t)? x[i++]: x[j++]; }
+    z = x; x = y; y = z; }
+
+  if(x!=R)                                   //Return the result to 'R'.
+    for(k=h; k<c; k++) R[k] = x[k];
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+SORT LIST BY RADIX
+
+This is a least-significant-digit radix sort, one byte at a time. Each pass
+counts the entries with each value of the byte, then moves them in that order
+between 'R' and 'S', keeping entries of equal value in the order they had, so
+that after the last pass the list is in order of time. Times are first taken
+relative to the earliest, so that only the bytes in which the times actually
+differ need to be passed over; for the events of a single bin that is usually
+four or five bytes rather than eight. The work is proportional to the length of
+the list, with no comparisons at all, which keeps a bin of a million events from
+stalling the dispatcher.
+
+Lists of 'QRP' or more are sorted by 'QPAR' threads together, each pass in two
+steps given to 'RSplit'. Each thread counts the values of the byte in its own
+part of the list, and from those counts each thread's part is given its own
+starting position for each value, following the parts before it. Each thread
+then moves the entries of its part, so that the order is exactly that of a
+single thread. The module itself is still called from one thread; the others
+exist only during the sort.
+
+ENTRY: 'h' indexes the first entry in 'R' to be sorted.
+       'c' follows the last.
+
+EXIT:  The entries are in order of time, equal times in their original order.
+*/
+
+static int Radix(int h, int c)
+{ int i, n, d, m, cnt[256]; unsigned long long lo, hi, k;
+  struct Qent *x, *y, *z;
+
+  lo = hi = RKEY(R[h].t);                    //Find the range of the times.
+  for(i=h+1; i<c; i++)
+  { k = RKEY(R[i].t);
+    if(lo>k) lo = k;
+    if(hi<k) hi = k; }
+
+  x = R+h; y = S+h; n = c-h;
+  for(d=0; d<64 && (hi-lo)>>d; d+=8)         //Pass over each byte in which
+  {
+#ifdef QPAR
+    if(n>=QRP)                               //(Give the largest lists to
+    { RSplit(x, y, n, lo, d);                //several threads.)
+      z = x; x = y; y = z; continue; }
+#endif
+    for(i=0; i<256; i++) cnt[i] = 0;         //the times differ, counting the
+    for(i=0; i<n; i++)                       //entries with each value.
+      cnt[(RKEY(x[i].t)-lo)>>d & 255] += 1;
+
+    for(i=m=0; i<256; i++)                   //Convert the counts to starting
+    { k = cnt[i]; cnt[i] = m; m += k; }      //positions.
+
+    for(i=0; i<n; i++)                       //Move the entries into order by
+    { m = (RKEY(x[i].t)-lo)>>d & 255;        //that byte.
+      y[cnt[m]++] = x[i]; }
+    z = x; x = y; y = z; }
+
+  if(x!=R+h)                                 //Return the result to 'R'.
+    for(i=0; i<n; i++) R[h+i] = x[i];
+  return 0;
+}
+
+#ifdef QPAR
+/*----------------------------------------------------------------------------*
+PASS OF RADIX SORT IN SEVERAL THREADS
+
+ENTRY: 'x' contains the 'n' entries to be moved, 'y' the area to receive them.
+       'lo' contains the earliest time in the list, as sorted.
+       'd' contains the lowest bit of the byte on which to sort.
+
+EXIT:  The entries are in 'y' in order of that byte, equal values in the order
+         they had in 'x'.
+*/
+
+static int RSplit(struct Qent *x, struct Qent *y, int n,
+                  unsigned long long lo, int d)
+{ int i, j, m, k; struct Qrdx *p;
+
+  for(j=0; j<QPAR; j++)                      //Divide the list into equal
+  { p = &Rp[j]; p->x = x; p->y = y;          //parts.
+    p->lo = lo; p->d = d;
+    p->a = (long long)n*j/QPAR; p->b = (long long)n*(j+1)/QPAR; }
+
+  RRun(RCount);                              //Count each part's values.
+
+  for(i=m=0; i<256; i++)                     //Convert the counts to starting
+  for(j=0; j<QPAR; j++)                      //positions, each value for each
+  { k = Rp[j].cnt[i]; Rp[j].cnt[i] = m; m += k; } //part in turn.
+
+  RRun(RMove);                               //Move each part's entries.
+  return 0;
+}
+
+/*
+'RRun' calls 'f' once for each part in 'Rp', the first in this thread and the
+others in threads of their own, and returns when all have finished. A part for
+which a thread cannot be started is done in this thread instead.
+*/
+
+static int RRun(void *(*f)(void*))
+{ int j; pthread_t th[QPAR]; char go[QPAR];
+
+  for(j=1; j<QPAR; j++)
+    go[j] = pthread_create(&th[j], 0, f, &Rp[j])==0;
+  f(&Rp[0]);
+  for(j=1; j<QPAR; j++)
+    if(go[j]) pthread_join(th[j], 0); else f(&Rp[j]);
+  return 0;
+}
+
+static void *RCount(void *v)
+{ int i; struct Qrdx *p = v;
+
+  for(i=0; i<256; i++) p->cnt[i] = 0;
+  for(i=p->a; i<p->b; i++)
+    p->cnt[(RKEY(p->x[i].t)-p->lo)>>p->d & 255] += 1;
+  return 0;
+}
+
+static void *RMove(void *v)
+{ int i, m; struct Qrdx *p = v;
+
+  for(i=p->a; i<p->b; i++)
+  { m = (RKEY(p->x[i].t)-p->lo)>>p->d & 255;
+    p->y[p->cnt[m]++] = p->x[i]; }
+  return 0;
+}
+#endif
+
+#ifndef QTICK
+/*
+'RBits' gives the bits of a floating point time as an unsigned integer which
+orders the same way: the sign bit is set for positive times and all bits are
+inverted for negative ones.
+*/
+
+static unsigned long long RBits(dec te)
+{ unsigned long long k;
+
+  memcpy(&k, &te, sizeof k);
+  return k>>63? ~k: k|(1ULL<<63);
+}
+#endif
+
+
+/*----------------------------------------------------------------------------*
+DISPATCH BEYOND THE HORIZON
+
+This routine is called when the bins are empty but events remain parked. Since
+the horizon is ordinarily the end of the simulation, the first event dispatched
+from here ordinarily ends it, and if the earliest parked event is known it is
+simply taken. Otherwise the parked events are listed in 'Pl' in order of time,
+once, and each call takes the next from the list. Events parked after that are
+placed in the list as they come, and entries left by events cancelled,
+rescheduled, or renumbered since are passed over.
+
+ENTRY: 'Qp' contains the number of events parked, at least one.
+       'Qpj' indexes the earliest, or is zero if that is not known.
+
+EXIT:  'Beyond' contains the number of the earliest parked event, which has
+         been released.
+       't' contains its time.
+*/
+
+static int Beyond()
+{ int n;
+
+  if(Qpo==0 && Qpj)                          //Take the earliest parked event
+  { n = Qpj; Qpj = 0; }                      //if it is known.
+
+  else                                       //Otherwise list the parked events
+  { if(Qpo==0) List();                       //if that has not been done, and
+    do n = Pl[Plh++].n;                      //take the next that is still
+    while(B[n]!=PPARK || T[n]!=Pl[Plh-1].t); //parked at the time listed.
+  }
+
+  B[n] = PEMPTY; Qp -= 1;                    //Release it and advance the global
+  if(Qp==0) Qpo = Plh = Plc = 0;             //time, dropping the list when no
+  Qx += 1; t = TIME(T[n]); return n;         //events remain parked.
+}
+
+/*
+'List' places every parked event in 'Pl' in order of time, equal times in order
+of event number, and starts dispatching from the list. 'Enlist' places event
+'n', newly parked, in its place among the entries not yet dispatched. 'PRoom'
+makes sure there is space for at least 'm' entries.
+*/
+
+static int List()
+{ int j;
+
+  Plh = Plc = 0; PRoom(Qp);
+  for(j=1; j<Pn; j++)
+    if(B[j]==PPARK) { Pl[Plc].t = T[j]; Pl[Plc].n = j; Plc += 1; }
+  qsort(Pl, Plc, sizeof(struct Qent), PCmp);
+  Qpo = 1; return 0;
+}
+
+static int Enlist(int n)
+{ int lo, hi, mid; struct Qent e;
+
+  PRoom(Plc+1);
+  e.t = T[n]; e.n = n;
+  for(lo=Plh,hi=Plc; lo<hi; )                //Find the first entry later than
+  { mid = (lo+hi)/2;                         //the new one.
+    if(PCmp(&Pl[mid], &e)>0) hi = mid; else lo = mid+1; }
+
+  memmove(&Pl[lo+1], &Pl[lo], (Plc-lo)*sizeof(struct Qent));
+  Pl[lo] = e; Plc += 1;
+  return 0;
+}
+
+static int PRoom(int m)
+{
+  if(m<=Pla) return 0;
+  if(Plh>0)                                  //Recover the space of events
+  { memmove(Pl, Pl+Plh, (Plc-Plh)*sizeof(struct Qent)); //already dispatched
+    Plc -= Plh; m -= Plh; Plh = 0;           //if there is any.
+    if(m<=Pla) return 0; }
+
+  Pla = max(m, 2*Pla);                       //Otherwise allocate more.
+  Pl = (struct Qent*)realloc(Pl, Pla*sizeof(struct Qent));
+  if(Pl==0) Error(911.);
+  return 0;
+}
+
+static int PCmp(const void *a, const void *b)
+{ const struct Qent *x = a, *y = b;
+
+  if(x->t!=y->t) return x->t<y->t? -1: 1;
+  return x->n<y->n? -1: x->n>y->n;
+}
+
+
+/*----------------------------------------------------------------------------*
+SET HORIZON
+
+This routine declares the time beyond which no events will be dispatched,
+ordinarily the end of the simulation. Events scheduled later than that are
+parked rather than placed in the bins, as described above. It may be called at
+any time. If the horizon is moved later, any parked events no longer beyond it
+are placed in their bins. If it is moved earlier, any events in the bins now
+beyond it are parked, so that none is dispatched ahead of an earlier one parked.
+
+ENTRY: 'th' contains the horizon.
+
+EXIT:  Events later than 'th' will be parked, and no event in the bins is later.
+*/
+
+EventHorizon(dec th)
+{ int j, s, r; qkey k; struct Qblk *b;
+
+  PINIT;                                     //Initialize if necessary.
+  TRACE('H', 0, th);                         //Record it if tracing.
+  if(Qtype) return;                          //(Only the calendar queue parks.)
+
+  if(th>Qh && Qp>0)                          //If the horizon is moving later,
+  { for(j=1; j<Pn; j++)                      //move events now within it from
+      if(B[j]==PPARK && TIME(T[j])<=th)      //the parking area to the bins.
+      { B[j] = PEMPTY; Qp -= 1; Bin(j, T[j]); }
+    Qpj = 0; Qpo = Plh = Plc = 0; }
+
+  if(th<Qh && Qe>0)                          //If it is moving earlier, move
+  for(j=1; j<Pn; j++)                        //events now beyond it from the
+  { if(B[j]<0) continue;                     //bins or the immediate list to
+    r = Qo && B[j]==Qi && (s=Seek(j))>=0;    //the parking area.
+    if(r) k = R[s].t;
+    else { b = Find(j, &s); k = b->t[s]; }
+    if(TIME(k)<=th) continue;
+    if(r) Unready(j); else Drop(j);
+    B[j] = PEMPTY; Qe -= 1; T[j] = k; Park(j); }
+
+  Qh = th;                                   //Set the new horizon.
+}
+
+
+/*----------------------------------------------------------------------------*
+HOLD EVENTS FOR LOADING
+
+This routine starts or ends the holding of events described above. It is meant
+to surround the construction of a large number of events at once, such as an
+initial population, during which events may be scheduled, cancelled,
+rescheduled, and renumbered as usual. Only the calendar queue holds events; for
+other kinds of queue the routine does nothing.
+
+ENTRY: 'k' is nonzero to start holding events, or zero to end.
+
+EXIT:  If 'k' is zero, all events held have been placed in their bins.
+*/
+
+EventLoad(int k)
+{
+  PINIT;                                     //Initialize if necessary.
+  TRACE('L', k, 0);                          //Record it if tracing.
+  if(Qtype) return;                          //(Only the calendar queue holds.)
+
+  Qg = k;                                    //Start or stop holding, loading
+  if(Qg==0) Load();                          //any events held.
+}
+
+
+/*----------------------------------------------------------------------------*
+SCHEDULE LIST OF EVENTS
+
+This routine schedules a list of events together, as if by 'EventSchedule' for
+each, but places them in the bins all at once as described above.
+
+ENTRY: 'v' contains the numbers of 'm' new events.
+       'w' contains the times at which they will occur.
+
+EXIT:  The events have been scheduled.
+*/
+
+EventBulkLoad(int v[], dec w[], int m)
+{ int j, g;
+
+  PINIT;                                     //Initialize if necessary.
+
+  TRACE('L', 1, 0);                          //Schedule each event, holding
+  g = Qg; Qg = 1;                            //them if the queue can, and then
+  for(j=0; j<m; j++)                         //load them unless holding was
+    EventSchedule(v[j], w[j]);               //already under way, recording
+  Qg = g; if(Qg==0) Load();                  //the holding if tracing.
+  TRACE('L', g, 0);
+}
+
+
+/*----------------------------------------------------------------------------*
+LOAD EVENTS HELD
+
+ENTRY: 'Qgn' contains the number of events held, marked 'PLOAD' in 'B' with
+         their times in 'T', all within the horizon.
+       'Qgh' contains the highest number of any of them.
+
+EXIT:  The events have been placed in their bins, with the number of bins
+         first enlarged as necessary to hold them.
+       No events are held.
+
+WORK:  The held events are found by scanning 'B' and counted for each bin. The
+       counts give where the events of each bin start in a list, the events are
+       entered in the list, and they are placed in order of bin from the list.
+*/
+
+static int Load()
+{ int i, j, n, nn, *c; qkey k; struct Qent *o;
+
+  if(Qgn==0) { Qgh = 0; return 0; }
+
+  for(nn=Qn; Qe+Qgn>2*nn; nn*=2);            //Enlarge the bins once to their
+  if(nn!=Qn)                                 //final number.
+    Resize(nn, Qr>0? QF*nn/Qr: Qw);
+
+  c = (int*)calloc(Qn+1, sizeof(int));       //Allocate the counts and the
+  o = (struct Qent*)malloc(Qgn*sizeof(struct Qent)); //list.
+  if(c==0||o==0) Error(911.);
+
+  for(n=1; n<=Qgh; n++)                      //Count the events for each bin,
+    if(B[n]==PLOAD)                          //placing any in the immediate list
+    { k = T[n]; QBIN(k, i);                  //that belong there.
+      if(QNOW(i,k)) { Ready(n, k); Qe += 1; }
+      else c[i+1] += 1; }
+
+  for(i=0; i<Qn; i++) c[i+1] += c[i];        //Convert the counts to starting
+                                             //positions in the list.
+  for(n=1; n<=Qgh; n++)                      //Enter the events in the list by
+    if(B[n]==PLOAD)                          //bin.
+    { k = T[n]; QBIN(k, i); j = c[i]++;
+      o[j].t = k; o[j].n = n; }
+
+  for(j=0; j<c[Qn-1]; j++)                   //Place them in their bins from
+    Put(o[j].n, o[j].t);                     //first to last.
+  Qe += j;
+
+  free(c); free(o);                          //Release the work areas.
+  Qgn = Qgh = 0; return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+RECORD TRACE
+
+This routine starts or ends the recording of every call to the entry points of
+this module. Each call is written as one record 'Qtrc', with 'op' containing a
+letter for the operation: 'T' for 'EventStartTime', 'Y' for 'EventType', 'S' for
+'EventSchedule', 'C' for 'EventCancel', 'R' for 'EventReschedule', 'N' for
+'EventRenumber', 'X' for 'EventNext', 'H' for 'EventHorizon', 'L' for
+'EventLoad', 'Z' for 'EventSize', and 'P' for 'EventPermute'. 'n' contains the
+event number or the integer argument and 't' the time, except that for
+'EventRenumber' 't' contains the old number, for 'EventPermute' the number of
+events renumbered, whose new numbers follow in as many 'p' records, and for
+'EventCancel' the current time. 'EventBulkLoad' is recorded as the events it
+schedules surrounded by the holding it does. For 'EventNext', the event
+dispatched and its time are recorded, so that a replay can check that it
+dispatches the same events.
+
+ENTRY: 'name' contains the name of the file to receive the trace, or is zero to
+         end recording.
+       If recording is starting, no other routine in this module has been
+         called since 'EventInit'.
+
+EXIT:  Any trace previously being recorded has been closed, and recording to
+         'name' has started if it is not zero.
+*/
+
+EventTrace(char *name)
+{
+  if(Qtf)                                    //Close any trace being recorded.
+  { if(fclose(Qtf)) Error(512.);
+    Qtf = 0; }
+
+  if(name==0) return;                        //Open the new one, if any.
+  Qtf = fopen(name, "wb");
+  if(Qtf==0) Error1(510., name,0);
+}
+
+static int Trace(int op, int n, dec te)
+{ struct Qtrc r;
+
+  r.t = te; r.n = n; r.op = op;              //Write one record.
+  if(fwrite(&r, sizeof r, 1, Qtf)!=1) Error(512.);
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+LOOK AHEAD IN THE QUEUE
+
+This routine tells the caller which events are likely to be dispatched soon, so
+that it can bring their records into cache while it handles the present event.
+Nothing is removed from the queue and the order of dispatch is unaffected, so a
+handler may still schedule, cancel, or reschedule any of the events returned.
+
+ENTRY: 'v' points to an array of at least 'k' elements.
+       'k' contains the number of events wanted.
+
+EXIT:  'EventPeek' contains the number of events returned in 'v', at most 'k'.
+         Those remaining in the immediate list come first, in order of
+         dispatch, followed by the first event of this cycle in each of the
+         next few bins.
+       The entries in 'B' for those events have been requested from memory,
+         ahead of 'EventNext'.
+*/
+
+int EventPeek(int v[], int k)
+{ int i, j, m;
+
+  if(Qtype) return 0;                        //(Only the calendar queue looks.)
+
+  for(m=0,j=Rh; j<Rc && m<k; j++)            //Collect the events remaining in
+    v[m++] = R[j].n;                         //the immediate list.
+
+  for(i=Qi+1; i<Qn && i<=Qi+k && m<k; i++)   //Add the first event in each of
+    if(Q[i].c>0 && Q[i].t[0]<Qt1)            //the bins that follow, if it
+      v[m++] = Q[i].n[0];                    //belongs to this cycle.
+
+  for(j=0; j<m; j++) prefetch(&B[v[j]]);     //Request their places in 'B'.
+  return m;
+}
+
+
+/*----------------------------------------------------------------------------*
+RUNNING STATISTICS
+
+The calendar queue counts its work as it goes, cheaply enough that the counts
+can be displayed with every report. A burst of events at one time, such as the
+construction of the initial population or the births at the turn of each year,
+shows as long bins to sort; a width that is too small shows as many cycles and
+a width that is too large as long sorts; and bins too few for the events
+pending show as long searches.
+
+ENTRY: 's' points to an array of at least six elements.
+
+EXIT:  's' contains, since the statistics were last taken: (0) the number of
+         bins sorted, (1) the average number of events in each, (2) the number
+         of events searched for in their bins, to be cancelled, rescheduled, or
+         renumbered, (3) the average number of steps in each search, (4) the
+         number of empty bins passed over, and (5) the number of cycles
+         completed through all the bins.
+       The counts are cleared for the next report.
+*/
+
+EventStats(dec s[])
+{
+  s[0] = Qsn; s[1] = Qsn>0? Qsl/Qsn: 0;      //Return the counts and averages.
+  s[2] = Qfn; s[3] = Qfn>0? Qfl/Qfn: 0;
+  s[4] = Qk;  s[5] = Qy;
+  Qsn = Qsl = Qfn = Qfl = Qk = Qy = 0;       //Clear them for the next time.
+}
+
+
+/*----------------------------------------------------------------------------*
+TUNE THE BINS
+
+This routine is called from 'EventNext' after every 'QS' events have been
+dispatched. It measures the rate at which events are coming due and rebuilds
+the bins if their number or their width has drifted by more than a factor of two
+from what that rate and the number of pending events call for.
+
+ENTRY: 'Qd' contains the number of events dispatched since time 'Qtd'.
+       't' contains the current time.
+
+EXIT:  'Qr' contains the rate at which events have been dispatched.
+       The bins have been rebuilt if necessary.
+       'Qd' and 'Qtd' are reset for the next measurement.
+*/
+
+static int Tune()
+{ int nn; dec w;
+
+  if(t<=Qtd) return 0;                       //Wait until time has advanced.
+
+  Qr = Qd/(t-Qtd);                           //Measure the rate of dispatch and
+  Qd = 0; Qtd = t;                           //start the next measurement.
+
+  nn = Qn;                                   //Halve the number of bins if they
+  if(Qe<Qn/2 && Qn>QMIN) nn = Qn/2;          //have become sparse, and compute
+  w = QF*nn/Qr;                              //the width that rate calls for.
+
+  if(nn!=Qn || w>2*Qw || w<Qw/2)             //Rebuild if the bins are far off.
+    Resize(nn, w);
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+REBUILD THE BINS
+
+ENTRY: 'nn' contains the new number of bins, a power of two.
+       'ww' contains the new width of all bins combined.
+       't' contains the current time. No pending event is earlier.
+
+EXIT:  All pending events have been redistributed into 'nn' bins spanning 'ww'
+         units of time, with the current time in the middle of the first bin.
+*/
+
+static int Resize(int nn, dec ww)
+{ int i, j, on; void *om; struct Qblk *oq, *ov, *b;
+
+  om = Qm; oq = Q; ov = V; on = Qn;          //Allocate the new bins, keeping
+  Qn = nn; Alloc();                          //the old ones until the events
+                                             //have been moved.
+  Width(ww); Cycle();                        //Start a new cycle at the present
+  Qz += 1;                                   //time, as 'EventStartTime' does.
+
+  for(j=Rh; j<Rc; j++)                       //Move every pending event to its
+    Put(R[j].n, R[j].t);                     //bin in the new arrangement,
+  Rh = Rc = 0;                               //first those in the immediate list
+                                             //and then those in the old bins.
+  for(i=0; i<on; i++)
+  for(b=&oq[i]; ; b=&ov[b->x])
+  { for(j=0; j<b->c; j++) Put(b->n[j], b->t[j]);
+    if(b->x==0) break; }
+
+  free(om); free(ov);                        //Release the old bins.
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+ALLOCATE THE BINS
+
+'Alloc' allocates 'Qn' empty bins, aligned on cache lines, and a fresh set of
+overflow blocks. 'Block' returns an empty overflow block, reusing a released one
+if there is one and allocating more if necessary.
+*/
+
+static int Alloc()
+{
+  Qm = calloc(Qn+1, sizeof(struct Qblk));    //Allocate the bins and align them
+  V  = (struct Qblk*)calloc(QV, sizeof(struct Qblk));
+  if(Qm==0||V==0) Error(911.);               //on a cache line.
+  Q  = (struct Qblk*)(((size_t)Qm+63) & ~(size_t)63);
+  Huge(Qm, (Qn+1)*sizeof(struct Qblk));
+  Vn = QV; Vu = 1; Vf = 0;
+  return 0;
+}
+
+/*----------------------------------------------------------------------------*
+ASK FOR HUGE PAGES
+
+'T', 'B', and the bins are reached nearly at random, so in ordinary 4 KB pages
+almost every access misses in the processor's table of address translations as
+well as in the cache. When 'QHUGE' is defined, the system is asked to back each
+array at least as large as a huge page with transparent huge pages, each of
+which one entry of that table covers. It is only a request; what the system
+grants depends on its settings and the memory free.
+
+ENTRY: 'p' points to an array of 'm' bytes, newly allocated and not yet used.
+
+EXIT:  The system has been asked for huge pages for as much of the array as they
+         can cover, if 'QHUGE' is defined.
+*/
+
+static int Huge(void *p, size_t m)
+{
+#if defined(QHUGE) && defined(MADV_HUGEPAGE)
+  size_t a, b;
+
+  if(m<QHP) return 0;                        //Find the whole huge pages in
+  a = ((size_t)p+QHP-1) & ~(size_t)(QHP-1);  //the array and ask for them.
+  b = ((size_t)p+m) & ~(size_t)(QHP-1);
+  if(b>a) madvise((void*)a, b-a, MADV_HUGEPAGE);
+#endif
+  return 0;
+}
+
+static int Block()
+{ int v;
+
+  if(Vf) { v = Vf; Vf = V[v].x; }            //Reuse a released block if there
+  else                                       //is one, or take a new one,
+  { if(Vu>=Vn)                               //allocating more if necessary.
+    { V = (struct Qblk*)realloc(V, 2*Vn*sizeof(struct Qblk));
+      if(V==0) Error(911.);
+      Vn *= 2; }
+    v = Vu++; }
+  V[v].c = V[v].x = 0; return v;
+}
+
+
+/*----------------------------------------------------------------------------*
+SET THE WIDTH OF THE BINS
+
+ENTRY: 'ww' contains the desired width of all bins combined.
+       'Qn' contains the number of bins.
+
+EXIT:  'Qw' contains the width of all bins combined. When times are kept in
+         ticks, this is rounded so the width of each bin, 'Qs', is a power of
+         two ticks.
+*/
+
+static int Width(dec ww)
+{
+#ifdef QTICK
+  Qs = (int)floor(log2(ww*QK/Qn)+0.5);       //Round the width of each bin to
+  if(Qs<0) Qs = 0;                           //a power of two ticks and keep
+  if(Qs>62-log2(Qn)) Qs = 62-log2(Qn);       //the cycle within range.
+  Qw = ldexp((dec)Qn, Qs)/QK;
+#else
+  Qw = ww;
+#endif
+  return 0;
+}
+
+
+/*----------------------------------------------------------------------------*
+START A CYCLE AT THE PRESENT TIME
+
+ENTRY: 't' contains the current time. No pending event is earlier.
+       'Qn' and 'Qw' define the bins.
+       The immediate list is empty or its events are to be returned to bins.
+
+EXIT:  'Qt0' and 'Qt1' bound a cycle of the bins containing 't'.
+       'Qi' indexes the bin containing 't', which is yet to be sorted.
+*/
+
+static int Cycle()
+{
+#ifdef QTICK
+  qkey k = KEY(t);                           //Align the cycle on a multiple of
+  Qt0 = k & -QSPAN; Qt1 = Qt0+QSPAN;         //its span and start from the bin
+  QBIN(k, Qi);                               //holding the present time.
+#else
+  Qt0 = t-(Qw/Qn)/2; Qt1 = Qt0+Qw;           //Place the present time in the
+  Qi  = 0;                                   //middle of the first bin.
+#endif
+  Qo = 0; return 0;
+}
+
+/*
+Note: The width must be measured from events actually dispatched rather than
+from the times of events pending, because most pending events in a population
+model are far in the future (deaths decades ahead, for example) while the events
+that matter for speed are those about to come due. Before any events have been
+dispatched, as during the construction of an initial population, the width is
+held at 'TW' and only the number of bins changes.
+*/
+
 /*----------------------------------------------------------------------------*
 DISPLAY PROFILE
 
@@ -420,17 +1931,26 @@ EXIT;  'EventProfile' contains the amount of memory allocated for the main data
 #define PROF 1001
 
 int EventProfile(char *label)
-{ int i, j, n, imax, prof[PROF];
-  dec nexp, lambda, eml, ln, nf;
+{ int i, n, imax, prof[PROF];
+  dec nexp, lambda, eml, ln, nf, w; struct Qblk *b;
+
+  if(Qtype)                                  //Let any other queue describe
+  { if(label==0||label[0]==0) label="Queue"; //itself.
+    n = QPASS(Profile, (label));
+    w = (dec)(clock()-Qc)/CLOCKS_PER_SEC;
+    if(Qx>0 && w>0)
+      printf("Dispatched %.0f events, %.0f per second.\n", Qx, Qx/w);
+    printf("\n"); return n; }
 
   if(label==0||label[0]==0) label = "Bin";   //Establish a default label.
 
   for(i=0; i<PROF; i++) prof[i] = 0;         //Clear the profile array.
 
   for(i=0; i<Qn; i++)                        //Count the number of bins that
-  { for(j=Q[i],n=0; j>0; j=P[j],n++)         //have no entries, one entry, two
-      if(j<1||j>=PN||n>PN)                   //entries, etc.
-        Error1(820.2, "j=",j);
+  { for(b=&Q[i],n=0; ; b=&V[b->x])           //have no entries, one entry, two
+    { n += b->c;                             //entries, etc., counting the
+      if(b->x==0) break; }                   //immediate list with its bin.
+    if(i==Qi && Qo) n += Rc-Rh;
     if(n>PROF-1) n = PROF-1;
     prof[n] += 1; }
 
@@ -451,31 +1971,20 @@ int EventProfile(char *label)
         i, i<PROF-1?' ':'+', prof[i], nexp);
     ln *= lambda; nf *= i+1; }
 
-  printf("\n");                              //Leave a blank line and return
-  return sizeof Q + sizeof T + sizeof P;     //with the size of the main data
-}                                            //structure.
-
-
-/*----------------------------------------------------------------------------*
-DETERMINE SORTING ORDER
-
-This routine is called from 'sort' when it needs to have two elements compared.
-
-ENTRY: 'p' indexes list element one.
-       'q' indexes list element two.
+  printf("Bins %d, cycle width %g, rebuilt %d times, %d overflow blocks.\n",
+    Qn, Qw, Qz, Vu-1);                       //Display the arrangement of the
+  if(Qp>0) printf("Parked %d events beyond time %g.\n", Qp, Qh);
+  w = (dec)(clock()-Qc)/CLOCKS_PER_SEC;      //bins and the rate of dispatch.
+  if(Qx>0 && w>0)
+    printf("Dispatched %.0f events, %.0f per second.\n", Qx, Qx/w);
 
-EXIT:  'order' contains a status code.
-        '<0' Element one is less than element two.
-        '=0' Element one is equal to element two.
-        '>0' Element one is greater than element two.
-*/
-
-int order(int p, int q)
-{ dec w;
-
-  w = T[p]-T[q]; return w<0? -1: w>0? 1: 0;
+  printf("\n");                              //Leave a blank line and return
+  return (Qn+1+Vn)*sizeof(struct Qblk)       //with the size of the main data
+       + 2*Ra*sizeof(struct Qent)            //structure.
+       + Pn*(sizeof(qkey)+sizeof(int));
 }
 
+
 /* (C) CLARENCE LEHMAN, UNIVERSITY OF MINNESOTA, AUGUST 2009.
 
 [To become open-source software as part of the modelling package.]
@@ -491,5 +2000,50 @@ Modifications
 3. Comments and names updated for general distribution, April 2011 [CLL].
 
 4. 'EventInit' added for serial reusability, May 2011 [CLL].
+
+5. Number and width of the time bins tuned while running, with the bins
+   rebuilt when either drifts, October 2026 [AGT].
+
+6. Bin of each event recorded when it is scheduled, so cancellation scans only
+   that bin, October 2026 [AGT].
+
+7. Times optionally held in integer ticks ('QTICK'), with bins found by shift
+   and mask, October 2026 [AGT].
+
+8. 'EventReschedule' added, and 'EventRenumber' made to replace the event in
+   its bin rather than cancel and reschedule it, October 2026 [AGT].
+
+9. 'EventType' added to select a heap, ladder queue, or timing wheel in place
+   of the calendar queue, October 2026 [AGT].
+
+10. 'EventPeek' added so the caller can prefetch the records of events about
+    to be dispatched, October 2026 [AGT].
+
+11. Running statistics kept and returned by 'EventStats', October 2026 [AGT].
+
+12. Events beyond a horizon set by 'EventHorizon' parked outside the bins,
+    October 2026 [AGT].
+
+13. Bins held as cache-line blocks of times and event numbers, replacing the
+    linked lists through 'P' and the sorting of them through 'sort.c', October
+    2026 [AGT].
+
+14. Crowded bins sorted by radix, and the most crowded by several threads
+    together ('QPAR'), October 2026 [AGT].
+
+15. Events held by 'EventLoad' and loaded by 'EventBulkLoad' placed in their
+    bins together, in order of bin, October 2026 [AGT].
+
+16. Calls to the entry points optionally recorded by 'EventTrace' for replay
+    by 'qreplay.c', October 2026 [AGT].
+
+17. 'T' and 'B' allocated at run time and enlarged by 'EventSize', rather than
+    sized for the largest population when compiled, October 2026 [AGT].
+
+18. Huge pages requested for 'T', 'B', and the bins ('QHUGE'), October 2026
+    [AGT].
+
+19. 'EventTimes' and 'EventPermute' added so the caller can reorder its records
+    and renumber the events in bulk, October 2026 [AGT].
 */
 
@@ -148,6 +148,32 @@ returned a value of unity. It should not, but this routine provides an
 additional safeguard against floating-point rounding anomalies.
 */
 
+/*----------------------------------------------------------------------------*
+POISSON DISTRIBUTION
+
+This function generates the number of independent events in an interval, such
+as those timed by 'Expon', given the mean number in the interval, by summing
+the probabilities of 0, 1, 2, ... events until they pass a uniform random
+number. Its time is proportional to the mean, which is small for its uses here;
+a large mean is split in halves, since the sum of two Poisson numbers is itself
+Poisson, so that 'exp(-m)' never underflows.
+
+ENTRY: 'm' contains the mean number of events, which must not be negative.
+
+EXIT:  'Poisson' contains a Poisson-distributed random number of mean 'm'.
+*/
+
+int Poisson(dec m)
+{ dec r, p, s; int k;
+
+  if(m>32) return Poisson(m/2)+Poisson(m/2); //Split a large mean.
+
+  r = Rand(); p = s = exp(-m);               //Find the number of events whose
+  for(k=0; r>s && p>0; )                     //cumulative probability first
+  { k += 1; p *= m/k; s += p; }              //reaches the random number.
+  return k;
+}
+
 /*----------------------------------------------------------------------------*
 NORMAL DISTRIBUTION
 
@@ -353,7 +379,8 @@ SELECT EARLIEST EVENT
 
 This routine searches for the earliest time in a subset of a table of times.
 
-ENTRY: 'tab' contains a table of times of future events.
+ENTRY: 'tab' contains a table of times of future events, as held in the
+         records of individuals.
        'subset' contains a vector of indexes into 'tab' that are to be included
          in the search. The vector ends with a negative value.
 
@@ -361,11 +388,11 @@ EXIT:  'Earliest' contains the index of the earliest time, selected from
          vector 'subset'.
 */
 
-int Earliest(dec tab[], int subset[])
+int Earliest(tick tab[], int subset[])
 { int i, m; dec x, w;
 
   for(x=100000000,m=i=0; subset[i]>=0; i++)
-  { w = tab[subset[i]]; if(x>w) { x = w; m = i; } }
+  { w = TGET(tab[subset[i]]); if(x>w) { x = w; m = i; } }
 
   return subset[m];
 }
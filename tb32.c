@@ -57,7 +57,8 @@ This is the main array of individuals. In this example there are 3 UK-born
 and 3 Non-UK-born individuals, with a total maximum population size ('indiv')
 of 14. Note, in SSAV version of the model, SSAs are stored as Non-UK born and
 it is not possible to tell from their ID number alone whether they are SSA or
-other non-UK born.
+other non-UK born. 'maximm' and 'indiv' are set from the data when the program
+starts (see 'Capacity') and raised if either part fills (see 'Grow').
 
 --What is in the array------Generic array index--------------------------------
 0  [Reserved]          (null pointer for list)
@@ -80,6 +81,11 @@ other non-UK born.
 16 Ext event, immigration    indiv+2 or IMM
 -----------------------------------------------------------------------------
 
+When 'STABLE' is set, an individual instead keeps its number from arrival to
+departure, and the numbers of those present are listed densely in 'D', in the
+places shown above, while numbers left behind are vacant (state 0) until taken
+again (see 'Vacate').
+
 4. MODEL FITTING
 The tb32 version of model accepts four variable disease parameters. These are:
 'df', 'd1uk20[M]', 'd2uk20[M]', and 'd3uk20[M]'. See the Data() function for
@@ -129,11 +135,68 @@ The actual starting seed, incorporating the time of day if requested by a
 negative value of 'randseq', is stored in 'rand0' and reported at the end of the
 run. That allows a run to be repeated exactly even if it was started with an
 arbitrary sequence.
+
+The kind of event queue is selected in the same way, with 'qtype=0' for the
+calendar queue (the default), 'qtype=1' for a four-way heap, 'qtype=2' for a
+ladder queue, or 'qtype=3' for a hierarchical timing wheel. All dispatch events
+in the same order except that events at precisely the same time may be taken in
+a different order. See 'schedule.c' and 'queues.c'.
+
+With 'qtrace=1' every call to the event scheduler is recorded in the file
+'events.trc', which the program 'qreplay' (built with 'makeqr') can feed back to
+the scheduler by itself, for timing it on the work of an actual run.
+
+With 'pmap=1' the list of individuals is held not in memory allocated from the
+system but in the files 'popa.map' and 'popc.map', created in the working
+directory and mapped into memory (they are removed from the directory as soon as
+they are opened, so nothing is left behind). The system then pages the list to
+and from the files as it is used, so a population larger than physical memory
+still runs, more slowly, instead of failing for want of memory. The system is
+told how the list is used: at random while events are dispatched, in order
+while 'Report' takes its census. 'Final' reports the page faults of the run and
+how much of the list is resident in memory at the end, whether mapped or not.
+
+With 'phuge=1' the list of individuals is held in huge pages, explicit ones if
+the system has set them aside and otherwise transparent ones, to spare the
+processor's table of address translations as events reach the list at random
+(see 'Pages'). 'Final' reports the kind of page obtained for each part of the
+list and how much of the program's memory is in transparent huge pages.
+
+With 'preord=1' the individuals of each part of the list are renumbered every
+'rgap' years (default 5) in order of their pending events, and with 'preord=2'
+in order of year of birth, so that records reached together lie together in
+memory (see 'Reorder'). 'Final' reports the time taken by the reordering and by
+each census.
+
+With 'pidx=1' the individuals in each state are also listed by region of birth,
+so that the number in any such stratum is known, and an individual drawn from
+it at random, without scanning the list of individuals (see 'Enlist'). 'Final'
+displays the numbers.
+
+With 'erep=1' a reported case is counted as soon as the disease starts, at the
+age and year of its report, and no event is scheduled for the report (see
+'Book'). Fewer events are dispatched; the numbers reported differ only by the
+particular random numbers drawn.
+
+With 'plazy=1' vaccination and the move from recent infection or reinfection to
+remote infection, 'LAT' years later, are not dispatched as events. Each is
+recorded when it is arranged and takes effect when the individual is next
+touched, and 'Report' brings 'N' up to date with those that have fallen due (see
+'Defer'). It cannot be combined with 'pidx'.
+
+With 'pmut=1' strain mutations are not scheduled as events. The number of them
+while an individual is in an infected or diseased state is drawn from a Poisson
+distribution when it leaves the state, or at the end of the run (see
+'Mutations'). 'Final' displays the number of mutations.
 */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include "common.h"
 #include "fileio.h"
 
@@ -148,8 +211,13 @@ arbitrary sequence.
                                //0=no, 1=yes (this changes population sizes).
 #define DPARAM 1               //Allows model to accept disease progression
                                //parameters (4 in this version), 0=no, 1=yes.
+#define STABLE 0               //Keeps each individual's index number while it
+                               //is present, 0=no, 1=yes (see 'Vacate').
 #define BIRTH (indiv+1)        //Index used for scheduling births.
 #define IMM   (indiv+2)        //Index for scheduling arrival of immigrants.
+#define PLACE(k) (STABLE? D[k]: (k)) //Individual in place 'k' (see 'Vacate').
+#define IMEND (STABLE? maximm: immid-1) //Highest index number which may be in
+#define UKEND (STABLE? indiv:  ukbid-1) //use, non-UK born and UK-born.
 #define RT    (T1-T0)          //Running time of model, calendar years.
 #define NUK   0                //Array index for non-UK born.
 #define UK    1                //Array index for UK-born.
@@ -165,6 +233,26 @@ arbitrary sequence.
 #define LAT 5                  //Years to Remote from recent (re)infection.
 #define BY (2010-1870+1)       //Number of birth cohorts for mortality data.
 
+// TIMES OF MUTATION AND TRANSMISSION, read and written through these; if
+// 'REDRAW', drawn afresh as needed, keeping only whether there is transmission.
+// A new time of mutation is drawn with 'NEWM', beyond the run if 'pmut'.
+#define NEWM(m)   (pmut? t+2*RT: t+Expon(m))
+#ifdef REDRAW
+#define GETM(n)   NEWM(A[n].state<=qI3? mi: md)
+#define GETT(n)   (A[n].spos? t+Expon(c[A[n].sex][A[n].rob]): t+2*RT)
+#define PUTM(n,w)
+#define PUTT(n,w) (A[n].spos = (w)>=t && (w)<t+2*RT)
+#else
+#define GETM(n)   TGET(Ac[n].tMutate)
+#define GETT(n)   TGET(Ac[n].tTransm)
+#define PUTM(n,w) (Ac[n].tMutate = TPUT(w))
+#define PUTT(n,w) (Ac[n].tTransm = TPUT(w))
+#endif
+
+// TIME FROM WHICH MUTATIONS ARE STILL TO BE COUNTED, if 'pmut' (see
+// 'Mutations'), held where the state leaves room.
+#define MARK(n)   (*(A[n].state>=qD1? &Ac[n].tDisease: &Ac[n].tRep))
+
 dec N[PN];                     //Current number in each disease state.
 dec N2[4][2][3][RT];           //Population sizes in the model at end of year by
                                //age, sex, and rob.
@@ -180,8 +268,8 @@ dec repc[4][2][3][2][RT];      //Array which holds reported cases for E&W
 
 int deaths;                    //Current number of deaths.
 int events;                    //Current number of events dispatched.
-int immid;                     //Next available ID number for immigrants.
-int ukbid;                     //Next available ID number for UK-born.
+int immid;                     //Next available place for immigrants.
+int ukbid;                     //Next available place for UK-born.
 int stid;                      //Next available ID for new strain types.
 
 extern dec t;                  //Current time (Managed by 'EventSchedule').
@@ -196,6 +284,7 @@ unsigned long rand0;           //Starting random number seed.
 
 struct Indiv *A;               //State of each individual, including their
                                //characterisitics, saved event times, etc.
+struct Indivc *Ac;             //Saved times needed only when infected.
 
 FILE *cc;                      //Create files pointers for output of
 FILE *rc;                      //cumulative cases (all) and reported cases.
@@ -210,6 +299,18 @@ int iimm = 1000000;            //Approximate initial number of immigrants (only
 int iukb = 10000000;           //Approximate initial number of UK-born (only
                                //used to set number of initial strain types).
 int maximm;                    //Maximum immigrants in pop'n at any time.
+int indiv;                     //Maximum population size (see 'Capacity').
+int *D;                        //Individuals present, by place, and the place
+int *Dx;                       //of each, if 'STABLE' (see 'Vacate').
+int *Ml[PN][2];                //Individuals in each state by region of birth,
+int  Mn[PN][2], Mc[PN][2];     //the number in each list and room for them,
+int *Mx;                       //and the place of each in its list, if 'pidx'.
+struct Lzy { dec w; int q; };  //Changes of state deferred, if 'plazy', by time
+struct Lzc { struct Lzy *v; int n, c; } *Lv;  //in cells of 1/LZC year, with
+int lzn;                       //the number in each cell and room for them, the
+dec lzt;                       //number of cells, and the time 'N' accounts for
+                               //them to.
+#define LZC 1024
 dec inf1981[121][3][2][9];     //Cumulative probabilities of the 9 disease
                                //states for pop. initialization (by a,s,rob).
 dec n1981[121][2][2];          //Numbers in each age/sex/rob category at
@@ -347,7 +448,20 @@ dec proprep = 0.75;            //Proportion of cases reported.
 
 dec relativetime = 0;          //Set for relative time reporting.
 dec randseq = 0;               //Random number sequence (set with 'randseq=N').
+dec qtype = 0;                 //Event queue, 0=Calendar 1=Heap 2=Ladder 3=Wheel.
+dec qtrace = 0;                //Set to record scheduler calls in 'events.trc'.
+dec pmap = 0;                  //Set to map the list of individuals from files.
+dec phuge = 0;                 //Set to hold the list of individuals in huge
+                               //pages.
+dec preord = 0;                //Set to reorder the list of individuals, 1 by
+                               //pending event, 2 by year of birth.
 dec tgap    = 0.5;             //Time between reports, years.
+dec rgap    = 5;               //Time between reorderings of the list, years.
+dec pidx    = 0;               //Set to list the individuals in each state.
+dec erep    = 0;               //Set to count case reports when disease starts.
+dec plazy   = 0;               //Set to defer vaccination and the move to
+                               //remote infection.
+dec pmut    = 0;               //Set to count strain mutations without events.
 dec kernel  = 0;               //Contagion kernel, 0=Panmictic, 1=Cauchy.
 dec sigma   = 1;               //Width of contagion kernel, where applicable.
 /*
@@ -452,9 +566,6 @@ main(int argc, char *argv[])
   FinalInit();                               //Start the final reports.
   ReportInit();                              //Start the output reports.
 
-  A = (struct Indiv *)                       //Allocate array of individuals.
-      calloc(indiv+3, sizeof(struct Indiv)); //(Not static because of gcc bug
-  if(A==0) Error(911.);                      //restricting such arrays to 2GB.)
 /*
 * cc = fopen(fn[0], "w");                    //Open output files and write
 * rc = fopen(fn[1], "w");                    //file headers to them.
@@ -467,9 +578,6 @@ main(int argc, char *argv[])
   c[M][UK] =c[F][UK] =6.0;                   //testing.
   df = 2.0; ehiv = 7.0;
 
-  if(SUPER) maximm = 10000000;               //Adjust 'maximm' depending on
-  else      maximm =  5000000;               //whether running on supercomp.
-
   Data();                                    //Read in appropriate data files
                                              //and store to arrays.
   gparam(argc, argv);                        //Collect parameters for this run
@@ -496,7 +604,12 @@ main(int argc, char *argv[])
   if(randseq>=0)  RandStart(rand0);          //from a specified or an arbitrary
   else rand0 = RandStartArb(rand0);          //place.
 
-  EventStartTime(t0);                        //Initialize the event queues.
+  if(qtrace) EventTrace("events.trc");       //Record calls to the scheduler
+                                             //if requested.
+  Capacity();                                //Size the list of individuals.
+  EventType((int)qtype);                     //Select the kind of event queue
+  EventStartTime(t0);                        //and initialize it, setting aside
+  EventHorizon(t1);                          //events after the end.
 
   t = t0;                                    //Set the starting time
 //stid = is1+is2;                            //Set first available new strain
@@ -513,9 +626,17 @@ main(int argc, char *argv[])
     pt = t; Report(argv[0]); }
 
   Report(argv[0]);                           //Get final report.
+  if(pmut) Strains();                        //Count the mutations still due.
 
   Final();                                   //Close processing and return to
-  free(A);                                   //caller.
+  A  = Space(A,  0, (size_t)(indiv+3)*sizeof(struct Indiv),  0); //caller.
+  Ac = Space(Ac, 1, (size_t)(indiv+3)*sizeof(struct Indivc), 0);
+  free(D); free(Dx); free(Mx); D = Dx = Mx = 0;
+  for(i=0; i<PN; i++)                        //Release the lists of the
+  for(j=0; j<2;  j++)                        //individuals in each state.
+  { free(Ml[i][j]); Ml[i][j] = 0; Mn[i][j] = Mc[i][j] = 0; }
+  for(i=0; i<lzn; i++) free(Lv[i].v);        //And the deferred changes of
+  free(Lv); Lv = 0; lzn = 0;                 //state.
 
   if(fit5i)                                  //If linked with the fitter, return
   { if(fitm) return out;                     //an array of notification rates or
@@ -541,16 +662,30 @@ EXIT:  The next event has been processed and 'events' incremented, if the
          event's time is less than 't1'.
        't' is advanced to the next event, which may be an unprocessed event at
          time greater than 't1'.
+
+Records of individuals are scattered through a large array, so nearly every
+event begins with a cache miss. While one event is processed, the records of the
+next few to come due are requested from memory through 'EventPeek'. The events
+are still dispatched one at a time, in strict order of time, since processing
+one may change another (a transmission, for example, can reschedule any
+individual).
 */
 
+#define LOOK 4                               //Events to look ahead.
+
 Dispatch()
-{ int n; dec tw;
+{ int n, i, v[LOOK]; dec tw;
 
 //-printf("About to dispatch an event...\n"); fflush(stdout);
   tw = t;                                    //Remember the previous time.
   n = EventNext(); if(t>t1) return;          //Advance time to the next event.
+
+  for(i=EventPeek(v,LOOK); i>0; i--)         //Request the records of the
+  { prefetch(&A[v[i-1]]);                    //events that follow.
+    prefetch((char*)(&A[v[i-1]]+1)-1); }
   tstep(tw, t);                              //Record the size of the time step.
   events += 1;                               //Increment the events counter.
+  if(A[n].lazy) Settle(n);                   //Make any change of state due.
 
   switch(A[n].pending)                       //Process the event.
   { case pVaccin:   Vaccination(n);  break;  //[vaccination]
@@ -625,14 +760,14 @@ int Birth(int n, dec b)
   //-we = b+Expon(em[s][1]);                 //Schedule time to emigration.
   we = b+EmDsn(1,s,t-b,em[s][UK]);           //Calculate time of emigration.
 
-  A[n].tBirth    = b;                        //Record the time of birth.
-  A[n].tDeath    = wd;                       //Record the time of death.
+  A[n].tBirth    = TPUTB(b);                 //Record the time of birth.
+  A[n].tDeath    = TPUT(wd);                 //Record the time of death.
   //-A[n].tEntry = b;                        //Record time of entry into state.
-  A[n].tEmigrate = we;                       //Record the time of emigration.
-  A[n].tExit     = 0;                        //Clear any other saved event
-  A[n].tDisease  = 0;                        //times.
-  A[n].tTransm   = 0;
-  A[n].tMutate   = 0;
+  A[n].tEmigrate = TPUT(we);                 //Record the time of emigration.
+  Ac[n].tExit     = 0;                       //Clear any other saved event
+  Ac[n].tDisease  = 0;                       //times.
+  PUTT(n, 0);
+  PUTM(n, 0);
   //-A[n].tInfected = 0;
   A[n].rob       = 1;                        //Set as born in UK.
   NewState(n, qU);                           //Mark as Uninfected.
@@ -659,10 +794,13 @@ int Birth(int n, dec b)
   default: Error1(611., "",(dec)VTYPE);      //Improper vaccination type.
   }
 
-  if(v)                                      //If vaccination occurs before
-  { A[n].pending = pVaccin;                  //death and emigration, schedule
+  if(v && plazy)                             //If vaccination occurs before
+    Defer(n, wv);                            //death and emigration, defer it
+
+  else if(v)                                 //with 'plazy', or else schedule
+  { A[n].pending = pVaccin;                  //the vaccination.
 //-printf("About to schedule vaccination from Birth()\n"); fflush(stdout);
-    EventSchedule(n, wv);                    //the vaccination.
+    EventSchedule(n, wv);
     return 1; }
 
   if(we<wd)                                  //Schedule emigration if that
@@ -734,6 +872,8 @@ int Immigrate(int n)
   //-A[n].bstate = 0;                        //Clear bstate.
 // SET UP BASIC, UNINFECTED IMMIGRANT
 
+  if(n<=maximm) A[n].rob = rob = 0;          //Assign rob=0 to all non-UK born.
+  else          A[n].rob = rob = 1;          //Assign rob=1 to UK-born.
   NewState(n,qU);                            //Assign to Uninfected state
                                              //to start with.
   //- printf ("time (t) is %f\n",t);
@@ -741,8 +881,6 @@ int Immigrate(int n)
   y = (int)t - (int)t0;                      //Get array index for year.
   //-A[n].tEntry = t;                        //Time of entry into this state.
   //-A[n].tImm   = t;                        //Assign time of immigration.
-  if(n<=maximm) A[n].rob = rob = 0;          //Assign rob=0 to all non-UK born.
-  else          A[n].rob = rob = 1;          //Assign rob=1 to UK-born.
 
   s = 0;                                     //Set sex as male to begin.
 
@@ -776,16 +914,16 @@ int Immigrate(int n)
   rob2=rob;                                  //Create 'rob2' (0,1 and 2)
   if(SSAV && A[n].ssa) rob2=2;               //since here 'rob' is only 0 or 1).
 
-  A[n].tBirth = t-age;                       //Save time of birth based on age.
+  A[n].tBirth = TPUTB(t-age);                //Save time of birth based on age.
 
-  A[n].tDeath = wd                           //Assign time of death and check
-              = t+LifeDsn(s,age,m1[s][y]);   //death time is ok.
+  A[n].tDeath = TPUT(wd                      //Assign time of death and check
+              = t+LifeDsn(s,age,m1[s][y]));  //death time is ok.
   //-A[n].tEmigrate = we = t+Expon em[s][rob2]  //Assign time of emigration.
-  if(wd<A[n].tBirth+age) Error(612.1);
+  if(wd<TGET(A[n].tBirth)+age) Error(612.1);
 
   A[n].tEmigrate                             //Assign emigration time.
-       = we
-       = t+EmDsn(rob2,s,age,em[s][rob2]);
+       = TPUT(we
+       = t+EmDsn(rob2,s,age,em[s][rob2]));
 //-printf("tDeath = %f\ttEmigrate = %f\n",A[n].tDeath,A[n].tEmigrate);
 
   if(age<v3[rob] && Rand()<v1[rob]*v2[rob]   //Determine if vaccination should
@@ -793,26 +931,28 @@ int Immigrate(int n)
     wv = t+(v3[rob]-age)+Rand();             //time if so. If it should not
   else wv = t+2*RT+Rand();                   //occur, set to time which will
                                              //not happen in the model.
-  if(wv<wd && wv<we)                         //Schedule vaccination if it is
-  { A[n].pending = pVaccin;                  //the earliest event.
+  if(wv<wd && wv<we && !plazy)               //Schedule vaccination if it is
+  { A[n].pending = pVaccin;                  //the earliest event (with 'plazy'
 //-printf("About to schedule vaccination from Immigration()\n"); fflush(stdout);
-    EventSchedule(n, wv); }
-
+    EventSchedule(n, wv); }                  //it is deferred instead, and
+                                             //'tExit' holds its time).
   else if(wd<we)                             //Schedule death if it is the
-  { A[n].tExit = wd;                         //earliest event.
+  { if(wv<wd) Defer(n, wv);                  //earliest event.
+    else Ac[n].tExit = TPUT(wd);
     A[n].pending = pDeath;
 //-printf("About to schedule death from Immigration()\n"); fflush(stdout);
     EventSchedule(n, wd); }
 
   else                                       //Otherwise schedule emigration if
-  { A[n].tExit = we;                         //it is the earliest event.
+  { if(wv<we) Defer(n, wv);                  //it is the earliest event.
+    else Ac[n].tExit = TPUT(we);
     A[n].pending = pEmigrate;
 //-printf("About to schedule emig from Immigration()\n"); fflush(stdout);
     EventSchedule(n, we); }
 
-  A[n].tDisease  = 0;                        //Clear time to disease.
-  A[n].tTransm   = 0;                        //Clear time to transmit.
-  A[n].tMutate   = 0;                        //Clear time of strain mutation.
+  Ac[n].tDisease  = 0;                       //Clear time to disease.
+  PUTT(n, 0);                                //Clear time to transmit.
+  PUTM(n, 0);                                //Clear time of strain mutation.
   //-A[n].tInfected = 0;                     //Clear time of infection.
 
   //if(rob2==0 && A[n].ssa<1 && Rand()<0.0)  //Add correction so that a fraction
@@ -891,14 +1031,14 @@ int Vaccination(int n)
 
   NewState(n, qV);                           //Change states.
 
-  if(A[n].tEmigrate<A[n].tDeath)             //Schedule emigration if that is
+  if(TGET(A[n].tEmigrate)<TGET(A[n].tDeath)) //Schedule emigration if that is
   { A[n].pending = pEmigrate;                //the earliest event.
 //-printf("About to schedule emigration from Vaccination()\n"); fflush(stdout);
-    EventSchedule(n, A[n].tEmigrate); }
+    EventSchedule(n, TGET(A[n].tEmigrate)); }
   else                                       //Otherwise, schedule death.
   { A[n].pending = pDeath;
 //-printf("About to schedule death from Vaccination()\n"); fflush(stdout);
-    EventSchedule(n, A[n].tDeath); }
+    EventSchedule(n, TGET(A[n].tDeath)); }
 
   return 0;
 }
@@ -959,7 +1099,8 @@ int Infect(int n, dec tinf, int strain)
 
   s   = A[n].sex;                            //Retrieve sex.
   rob = A[n].rob;                            //Retrieve region of birth.
-  a   = (int)(t-A[n].tBirth);                //Retrieve integer age.
+  a   = (int)(t-TGET(A[n].tBirth));          //Retrieve integer age.
+  if(A[n].lazy) Settle(n);                   //Make any change of state due.
 
   switch(A[n].state)                         //Determine the new state and
   {                                          //its associated parameters.
@@ -974,54 +1115,59 @@ int Infect(int n, dec tinf, int strain)
 //-printf("Info on n: A[n].pending = %d at time %f, current time is %f\n",
 //-A[n].pending, A[n].t,t);
 
-  EventCancel(n);                            //Else cancel the pending event and
-  NewState(n, q);                            //mark this individual as infected.
+  NewState(n, q);                            //Else mark this individual as
+                                             //infected. (The pending event is
+                                             //rescheduled below.)
   //A[n].tInfected = t-tinf;                 //Save time of infection.
   //A[n].inf        = 1;                     //Save place of infection as UK
                                              //(will be changed outside routine
                                              //if infection is acquired abroad).
   //-A[n].strain = strain;                   //Assign strain type ID number.
 
-  wd = A[n].tDeath;                          //Retrieve time of death.
-  we = A[n].tEmigrate;                       //Retrieve time of emigration.
+  wd = TGET(A[n].tDeath);                    //Retrieve time of death.
+  we = TGET(A[n].tEmigrate);                 //Retrieve time of emigration.
 //-wr = t+Expon(r);                          //Calculate recovery (old way).
   wr = t+LAT-tinf;                           //After 'LAT' years individual is
                                              //defined as remotely infected.
 //-wdis = t+Expon(d);                        //Calculate disease (old way).
   wdis = t+Tdis(n,a,s,rob,tinf)+E;           //Calculate time to disease.
   if(wdis<=t) Error2(620.0,"t=",t, " wdis=",wdis);
-  wm   = t+Expon(mi);                        //Calculate strain mutation time.
+  wm   = NEWM(mi);                           //Calculate strain mutation time.
 
   if(wd<we && wd<wr && wd<wdis && wd<wm)     //If death is earliest event,
   { A[n].pending = pDeath;                   //schedule the death and
 //-printf("About to schedule death from Infect()\n"); fflush(stdout);
-    EventSchedule(n, wd);                    //ignore everything else.
+    EventReschedule(n, wd);                  //ignore everything else.
     return 3; }
 
   if(we<wr && we<wdis && we<wm)              //If emigration is the earliest
   { A[n].pending = pEmigrate;                //event, schedule it and
 //-printf("About to schedule emigration from Infect()\n"); fflush(stdout);
-    EventSchedule(n, we);                    //ignore everything else.
+    EventReschedule(n, we);                  //ignore everything else.
     return 5; }
 
-  if(wr<wdis && wr<wm)                       //Otherwise, if transition to
-  { A[n].pending = pRemote;                  //remote infection would occur
+  if(wr<wdis && wr<wm && plazy)              //Otherwise, if transition to
+  { Latent(n, wr, wm, 1);                    //remote infection would occur
+    return 1; }                              //before disease and mutation,
+                                             //defer it with 'plazy', or else
+  if(wr<wdis && wr<wm)                       //schedule latency, save mutation
+  { A[n].pending = pRemote;                  //time, and ignore disease.
 //-printf("About to schedule remote from Infect()\n"); fflush(stdout);
-    EventSchedule(n, wr);                    //before disease and mutation,
-    A[n].tMutate = wm;                       //schedule latency, save mutation
-    return 1; }                              //time, and ignore disease.
+    EventReschedule(n, wr);
+    PUTM(n, wm);
+    return 1; }
 
   if(wm<wdis)                                //Otherwise, if mutation should
   { A[n].pending = pMutate;                  //occur before disease, schedule
 //-printf("About to schedule mutation from Infect()\n"); fflush(stdout);
-    EventSchedule(n, wm);                    //mutation and save time to disease
-    A[n].tDisease = wdis;                    //onset and time to remote.
-    A[n].tExit = wr;
+    EventReschedule(n, wm);                  //mutation and save time to disease
+    Ac[n].tDisease = TPUT(wdis);             //onset and time to remote.
+    Ac[n].tExit = TPUT(wr);
     return 4; }
 
   { A[n].pending = pDisease;                 //Otherwise, schedule disease and
 //-printf("About to schedule disease from Infect()\n"); fflush(stdout);
-    EventSchedule(n, wdis);                  //do not save others, as they will
+    EventReschedule(n, wdis);                //do not save others, as they will
     return 2; }                              //be recalculated at disease onset.
 }
 
@@ -1040,7 +1186,7 @@ ENTRY: 'n' indexes the individual.
        't' contains the current time.
        'A[n].state' contains the present state (can be 'qI1', 'qI3',
          'qD1'-'qD6').
-       'A[n].tMutate' contains the strain mutation time.
+       'Ac[n].tMutate' contains the strain mutation time.
        'd2' contains the disease progression rate for 'qI2'.
        'm4' contains the mortality rate for 'qI2'.
        No event is scheduled for individual 'n'.
@@ -1052,7 +1198,7 @@ EXIT:  'Remote' contains a status code:
          5 Emigration is scheduled.
        'A[n].state' represents Remote Infection (qI2).
        'A[n].tDeath' is updated as necessary.
-       'A[n].tMutate' is updated as necessary.
+       'Ac[n].tMutate' is updated as necessary.
        Counters in 'N' are updated.
 */
 
@@ -1061,7 +1207,7 @@ int Remote(int n)
 
 //-printf("Starting Remote routine...\n"); fflush(stdout);
   y   = (int)t - (int)t0;                    //Retrieve array index for year.
-  age = t-A[n].tBirth;                       //Retrieve age.
+  age = t-TGET(A[n].tBirth);                 //Retrieve age.
   a   = (int) age;                           //Integer age.
   s   = A[n].sex;                            //Retrieve sex.
   rob = A[n].rob;                            //Retrieve region of birth.
@@ -1071,13 +1217,13 @@ int Remote(int n)
 
   if(q>=qD1)                                 //Establish a new time for strain
   {  //A[n].tDeath = t+LifeDsn(s,age,m1[s][y]);//mutation if the prior state
-     A[n].tMutate = t+Expon(mi); }           //was disease.
+     PUTM(n, NEWM(mi)); }                    //was disease.
 
 //-wdis = t+Expon(d2[s][rob][a]);            //Calculate time to disease (old).
   wdis = t+Tdis(n,a,s,rob,0);                //Calculate time to disease.
-  wd = A[n].tDeath;                          //Retrieve time of death.
-  we = A[n].tEmigrate;                       //Retrieve time of emigration.
-  wm = A[n].tMutate;                         //Retrieve time of mutation.
+  wd = TGET(A[n].tDeath);                    //Retrieve time of death.
+  we = TGET(A[n].tEmigrate);                 //Retrieve time of emigration.
+  wm = GETM(n);                              //Retrieve time of mutation.
 
 //-printf("wdis = %f\twd = %f\twe = %f\twm = %f\n",wdis,wd,we,wm);
 
@@ -1091,7 +1237,7 @@ int Remote(int n)
   { A[n].pending = pMutate;                  //occurs before disease and
 //-printf("About to schedule mutation from Remote()\n"); fflush(stdout);
     EventSchedule(n, wm);                    //emigration, schedule strain
-    A[n].tDisease = wdis;                    //mutation and save disease time.
+    Ac[n].tDisease = TPUT(wdis);             //mutation and save disease time.
     return 4; }
 
   if(we<wdis)                                //Otherwise, if emigration occurs
@@ -1122,6 +1268,12 @@ originates from the disease compartments. In addition to infecting others,
 diseased individuals can recover to remote infection, die, emigrate, be
 reported or have their infection strain mutate.
 
+The time of a report is drawn before the earliest of recovery, death, and
+emigration, none of which can then change, so a case to be reported is always
+reported while still in the same state. With 'erep' set the case is therefore
+counted here, with its age and year at the time of the report, and no report is
+scheduled.
+
 ENTRY: 'n' indexes the individual progressing to disease.
        't' contains the current time.
        'A[n].state' contains the state progressing to disease (can be
@@ -1141,6 +1293,7 @@ ENTRY: 'n' indexes the individual progressing to disease.
        'c' contains the average number of new infections produced by this
          individual per year.
        'proprep' contains the proportion of cases reported.
+       'erep' is set to count a reported case here rather than when reported.
        'md' contains the mutation rate for strains involved in disease.
        No event is scheduled for individual 'n'.
 
@@ -1153,11 +1306,13 @@ EXIT:  'Disease' contains a status code.
          6 Case report is scheduled.
        'A[n].state' contains the new state.
        'A[n].tDeath' contains a possibly updated time of death.
-       'A[n].tMutate' contains the new time of strain mutation, if applicable.
-       'A[n].tTransm' contains the next time of transmission, if applicable.
-       'A[n].tExit' contains the time of recovery to remote infection, or if
+       'Ac[n].tMutate' contains the new time of strain mutation, if applicable.
+       'Ac[n].tTransm' contains the next time of transmission, if applicable.
+       'Ac[n].tExit' contains the time of recovery to remote infection, or if
          would happen after death, the time of death.
-       'A[n].tRep' contains the time of disease case report, if applicable.
+       'Ac[n].tRep' contains the time of disease case report, if applicable,
+         or if 'erep' is set a time beyond the run, the case having been added
+         to 'repc' if it is reported within the run.
        Counters in 'N' are updated.
 */
 
@@ -1166,7 +1321,7 @@ int Disease(int n)
 
 //-printf("Starting  Disease routine...\n"); fflush(stdout);
 
-  age = t-A[n].tBirth;                       //Retrieve age.
+  age = t-TGET(A[n].tBirth);                 //Retrieve age.
   a   = (int)age;                            //Calculate integer age.
   s   = A[n].sex;                            //Retrieve sex.
   rob = A[n].rob;                            //Retrieve region of birth, 0 or 1.
@@ -1191,10 +1346,10 @@ int Disease(int n)
 //-printf("About to put case in cumulative cases....\n"); fflush(stdout);
   Cumul(n,t);                                //Add individual to cumulative cases.                  *Note name....
 
-  wr = A[n].tExit = t+RecovDsn(s,age,r);     //Establish time to remote.
-  we = A[n].tEmigrate;                       //Retrieve emigration time.
-  wd = A[n].tDeath;                          //Retrieve time of death.
-  A[n].tMutate = wm = t+Expon(md);           //Establish new mutation time.
+  Ac[n].tExit = TPUT(wr = t+RecovDsn(s,age,r)); //Establish time to remote.
+  we = TGET(A[n].tEmigrate);                 //Retrieve emigration time.
+  wd = TGET(A[n].tDeath);                    //Retrieve time of death.
+  wm = NEWM(md); PUTM(n, wm);                //Establish new mutation time.
 
   if(q>=qD4) ds = 0;                         //Set disease site to non-pulmonary
   else       ds = 1;                         //or pulmonary.
@@ -1209,7 +1364,7 @@ int Disease(int n)
 
 //-printf("Disease death time is %f and recovery time is %f\n",wd,wr);
                                              //Since disease death is before
-    A[n].tDeath = wd; }                      //natural death time, replace it.
+    A[n].tDeath = TPUT(wd); }                //natural death time, replace it.
 
   if(Rand()<proprep)                         //If case should be reported, find
   { if(wr<wd && wr<we) e = wr;               //reporting time.
@@ -1218,15 +1373,19 @@ int Disease(int n)
                                              //to get range for reporting time.
     else               e = we;
 
-    A[n].tRep = t+Rand()*(e-t); }            //Randomly assign reporting time.
+    Ac[n].tRep = TPUT(t+Rand()*(e-t)); }     //Randomly assign reporting time.
 
   else                                       //If case should not be reported,
-    A[n].tRep = t+2*RT+Rand();               //assign a reporting time beyond
+    Ac[n].tRep = TPUT(t+2*RT+Rand());        //assign a reporting time beyond
                                              //running time of model.
 
-  if(A[n].tRep==0) Error1(619., "n=",n);
-  wrep = A[n].tRep;                          //Save reporting time.
-//-printf("tRep is %f\n", A[n].tRep); fflush(stdout);
+  if(Ac[n].tRep==0) Error1(619., "n=",n);
+  wrep = TGET(Ac[n].tRep);                   //Save reporting time.
+
+  if(erep)                                   //If reports are counted at once,
+  { if(wrep<=t1) Book(n, wrep);              //count this one if it falls within
+    Ac[n].tRep = TPUT(wrep = t+2*RT); }      //the run and never schedule it.
+//-printf("tRep is %f\n", Ac[n].tRep); fflush(stdout);
 
   if(wd<wr)      /* Delete if 'Earliest' */  //If death would occur before
      wr = wd;    /* is incorporated.     */  //recovery, give death precedence.
@@ -1235,7 +1394,7 @@ int Disease(int n)
   if(q<qD4 && Rand()<smear[a])               //If this is pulmonary disease and
     wt = t+Expon(c[s][rob]);                 //it is smear positive, set time
   else wt = t+2*RT + Rand();                 //to transmit if smear negative,
-  A[n].tTransm = wt;
+  PUTT(n, wt);
 
   if(wt<wr && wt<wm && wt<we && wt<wrep)     //set 'wt' so transmission never
   { A[n].pending = pTransm;                  //happens. If transmission is
@@ -1290,18 +1449,18 @@ strain mutation, recovery, case report emigration or death.
 
 ENTRY: 'n' indexes the individual to transmit an infection.
        't' contains the current time.
-       'A[n].tExit' contains the time of recovery, or if that time
+       'Ac[n].tExit' contains the time of recovery, or if that time
          is equal to or greater than the time of death, contains time of death.
        'A[n].tDeath' contains the time of death.
-       'A[n].tMutate' contains the strain type mutation time.
+       'Ac[n].tMutate' contains the strain type mutation time.
        'A[n].tEmigrate' contains the emigration time.
        'A[n].rob' contains the region of birth.
        'A[n].sex' contains the sex.
        'A[n].strain' contains the infection strain ID number.
        'pcc' contains the proportion of close contacts.
-       Non-UK born individuals are indexed from 1 to (immid-1), a total of
+       Non-UK born individuals are in places 1 to (immid-1), a total of
          (immid-1) individuals.
-       UK-born individuals are indexed from (maximm+1) to (ukbid-1), a total
+       UK-born individuals are in places (maximm+1) to (ukbid-1), a total
          of (ukbid-maximm-1) individuals.
        No event is scheduled for individual 'n'.'
 
@@ -1318,10 +1477,10 @@ EXIT:  A new individual has been targeted for infection. If the infection takes
        Counters in 'N' are updated.
 */
 
-#define SCHED(X,Y,Z)  { A[n].pending = X; EventSchedule(n,Y); return Z; }
+#define SCHED(X,Y,Z) { A[n].pending = X; EventSchedule(n,TGET(Y)); return Z; }
 
 int Transmission(int n)
-{ int i, j, low, tot; dec age;
+{ int i, j, low, tot; dec age, wt; tick w[8];
   static int v[] = { iTransm,iDeath,iEmigrate,iExit,iMutate,iRep, -1 };
 
 //- printf("Starting Transmission routine...\n"); fflush(stdout);
@@ -1334,15 +1493,15 @@ int Transmission(int n)
     { low  = 1;
       tot = immid-1 - low + 1; }
 
-    do i=low+(int)(Rand()*tot);              //Find person other than self to
+    do i=PLACE(low+(int)(Rand()*tot));       //Find person other than self to
       while(i==n); }                         //infect.
 
   else                                       //If not a 'close contact', choose
   { do                                       //random person to infect from
     { tot = (immid-1) + (ukbid-maximm-1);    //entire population.
       j = 1 + (int)(Rand()*tot);
-      if(j>=immid) i = j+(maximm+1-immid);   //Adjust ID numbers for UK-born.
-      else i = j; }
+      if(j>=immid) j += maximm+1-immid;      //Adjust places for UK-born.
+      i = PLACE(j); }
     while (i==n);                            //Avoid infecting self.
   }
 //-printf("About to infect chosen person from Trans()\n"); fflush(stdout);
@@ -1351,15 +1510,22 @@ int Transmission(int n)
                                              //(Infect for non-genetic model)
   Infect(i,0,0);                             //Infect chosen individual.
 
-  A[n].tTransm=t+Expon(c[A[n].sex][A[n].rob]); //Establish time to transmit again.
-
-  switch(i=Earliest(A[n].t, v))              //Schedule the earliest event.
-  { case iRep:      SCHED(pRep,      A[n].tRep,      6);
-    case iTransm:   SCHED(pTransm,   A[n].tTransm,   1);
-    case iExit:     SCHED(pRemote,   A[n].tExit,     2);
-    case iMutate:   SCHED(pMutate,   A[n].tMutate,   4);
-    case iEmigrate: SCHED(pEmigrate, A[n].tEmigrate, 5);
-    case iDeath:    SCHED(pDeath,    A[n].tDeath,    3);
+  wt = t+Expon(c[A[n].sex][A[n].rob]);       //Establish time to transmit
+  PUTT(n, wt);                               //again.
+
+  w[iTransm]   = TPUT(wt);                   //Gather the times from both
+  w[iDeath]    = A[n].tDeath;                //parts of the record and
+  w[iEmigrate] = A[n].tEmigrate;             //schedule the earliest event.
+  w[iExit]     = Ac[n].tExit;
+  w[iMutate]   = TPUT(GETM(n));
+  w[iRep]      = Ac[n].tRep;
+  switch(i=Earliest(w, v))
+  { case iRep:      SCHED(pRep,      w[iRep],      6);
+    case iTransm:   SCHED(pTransm,   w[iTransm],   1);
+    case iExit:     SCHED(pRemote,   w[iExit],     2);
+    case iMutate:   SCHED(pMutate,   w[iMutate],   4);
+    case iEmigrate: SCHED(pEmigrate, w[iEmigrate], 5);
+    case iDeath:    SCHED(pDeath,    w[iDeath],    3);
     default:        Error1(922., "m=",(dec)i);           }
 
   return 0;                                //(Will never reach this.)
@@ -1384,12 +1550,12 @@ ENTRY: 'n' indexes an individual whose strain type is to mutate
          strain of infection or disease.
        'A[n].tDeath' contains the saved time of death.
        'A[n].tEmigrate' contains the saved time of emigration.
-       'A[n].tExit' contains the saved time to exit state.
-       'A[n].tTransm' contains the saved time to transmit again.
+       'Ac[n].tExit' contains the saved time to exit state.
+       'Ac[n].tTransm' contains the saved time to transmit again.
        No event is scheduled for individual 'n'.
 
 EXIT:  The next event for individual 'n' is scheduled.
-       'A[n].tMutate' contains the time of next scheduled strain mutation.
+       'Ac[n].tMutate' contains the time of next scheduled strain mutation.
        'Mutation' contains a status code.
          1 Recovery to remote infection is scheduled.
          2 Progression to disease is scheduled.
@@ -1412,13 +1578,14 @@ Mutate(int n)
   else m = md;                               //rate and calculate time to
   wm = t+Expon(m);                           //mutate again.
 
-  wd   = A[n].tDeath;                        //Get time of death.
-  we   = A[n].tEmigrate;                     //Get time of emigration.
-  wdis = A[n].tDisease;                      //Get time of disease.
-  wr   = A[n].tExit;                         //Get time to remote infection.
+  wd   = TGET(A[n].tDeath);                  //Get time of death.
+  we   = TGET(A[n].tEmigrate);               //Get time of emigration.
+  wdis = TGET(Ac[n].tDisease);               //Get time of disease.
+  wr   = TGET(Ac[n].tExit);                  //Get time to remote infection.
 
-  if(A[n].state==qI2)                        //Schedule events for remotely
-  {                                          //infected individuals (qI2).
+  if(A[n].state==qI2 || A[n].lazy)           //Schedule events for remotely
+  {                                          //infected individuals (qI2), or
+                                             //those to become so ('Latent').
     if(wd<we && wd<wdis && wd<wm)
     { A[n].pending = pDeath;                 //If death would occur before
 //-printf("About to schedule death from Mutate()\n"); fflush(stdout);
@@ -1451,12 +1618,16 @@ Mutate(int n)
 //-printf("About to schedule death2 from Mutate()\n"); fflush(stdout);
       return 3; }                            //ignore everything else.
 
-    if(wr<wdis && wr<wm && wr<we)            //Otherwise, if transition to
-    { A[n].pending = pRemote;                //remote infection would occur
+    if(wr<wdis && wr<wm && wr<we && plazy)   //Otherwise, if transition to
+    { Latent(n, wr, wm, 0);                  //remote infection would occur
+      return 1; }                            //before disease and mutation,
+                                             //defer it with 'plazy', or else
+    if(wr<wdis && wr<wm && wr<we)            //schedule latency and save
+    { A[n].pending = pRemote;                //mutation time.
 //-printf("About to schedule remote2 from Mutate()\n"); fflush(stdout);
-      EventSchedule(n, wr);                  //before disease and mutation,
-      A[n].tMutate = wm;                     //schedule latency and save
-      return 1; }                            //mutation time.
+      EventSchedule(n, wr);
+      PUTM(n, wm);
+      return 1; }
 
     if(wm<wdis && wm<we)                     //Otherwise, if mutation should
     { A[n].pending = pMutate;                //occur before disease, schedule
@@ -1478,23 +1649,23 @@ Mutate(int n)
 
 
   {                                          //Schedule events for diseased.
-    wrep = A[n].tRep;                        //Get time of case report.
-//-printf("A[n].tRep is %f\n", A[n].tRep); fflush(stdout);
+    wrep = TGET(Ac[n].tRep);                 //Get time of case report.
+//-printf("Ac[n].tRep is %f\n", Ac[n].tRep); fflush(stdout);
 
     if(A[n].state<qD4)                       //If this is pulmonary disease,
-    { wt = A[n].tTransm;                     //retrieve time for transmission
+    { wt = GETT(n);                          //retrieve time for transmission
       if(wt<wd && wt<wr && wt<wm && wt<we && wt<wrep)
       { A[n].pending = pTransm;              //and if it occurs before
 //-printf("About to schedule tranms3 from Mutate()\n"); fflush(stdout);
         EventSchedule(n, wt);                //anything else, schedule it
-        A[n].tMutate = wm;                   //and save mutation time.
+        PUTM(n, wm);                         //and save mutation time.
         return 1; } }
 
     if(wrep<wd && wrep<wr && wrep<wm && wrep<we)
     { A[n].pending = pRep;                  //If case report should occur
 //-printf("About to schedule case report3 from Mutate()\n"); fflush(stdout);
       EventSchedule(n, wrep);               //before anything else, schedule
-      A[n].tMutate = wm;                    //it and save mutation time.
+      PUTM(n, wm);                           //it and save mutation time.
       return 6; }
 
     if(wr<wd && wr<wm && wr<we)              //If recovery will occur before
@@ -1534,12 +1705,12 @@ ENTRY: 'n' indexes an individual who has just died.
        't' contains the current time.
        'A[n].state' contains the present state (can be any compartment).
        'A[n].tBirth' contains the time of birth.
-       'ukbid' contains the next available index number for UK-born individuals.
+       'ukbid' contains the next available place for UK-born individuals.
        No event is scheduled for individual 'n'.
 
 EXIT:  Either entry 'n' is sent to the Birth() function, to be initialized as a
         susceptible newborn and function returns '0' (DTYPE==0) or index number
-       is recycled with 'Transfer' (DTYPE==1), no birth is generated and
+       is released with 'Vacate' (DTYPE==1), no birth is generated and
        function returns '1'.
        N[A[n].state] is decremented.
        'deaths' is incremented.
@@ -1550,13 +1721,16 @@ EXIT:  Either entry 'n' is sent to the Birth() function, to be initialized as a
 #define DTYPE 1                              //Allows for non-constant population
                                              //size.
 Death(int n)
-{ int n2; dec age;
+{ dec age;
 
 //- printf("Starting Death routine...\n"); fflush(stdout);
 
   deaths += 1;                               //Increment the number of deaths.
   N[A[n].state]-=1;                          //Decrement N[A[n].state].
-  age = t-A[n].tBirth;                       //Compute the age at death.
+  if(pidx) Unlist(n);
+  if(A[n].lazy) Undefer(n);
+  if(pmut && A[n].state>=qI1) Mutations(n, t);
+  age = t-TGET(A[n].tBirth);                 //Compute the age at death.
 
   { age1[0] += age; age2[0] += age*age;      //Accumulate statistics for mean
     agec[0] += 1; }                          //age and its variance.
@@ -1571,14 +1745,7 @@ Death(int n)
   { Birth(n, t);                             //constant, initiate a birth.
     return 0; }
 
-  if(A[n].rob)                               //Avoid unoccupied index numbers
-  { n2 = ukbid-1; ukbid--; }                 //in array 'A' by transferring
-                                             //highest-numbered individual, 'n2',
-  else                                       //to index number 'n'.
-  { n2 = immid-1; immid--; }
-
-//-printf("About to call Transfer() from Death() with n=%d  n2=%d\n",n, n2);
-  Transfer(n, n2);
+  Vacate(n);                                 //Release the index number.
   return 1;
 }
 
@@ -1590,8 +1757,7 @@ EMIGRATION
 This routine logs individuals out of compartments as they leave the study
 population, maintaining numbers in each compartment so that the array of
 individuals never has to be scanned for that information. Also, the
-individual's index number is recycled with 'Transfer' so that array 'A'
-is always continuous.
+individual's index number is released with 'Vacate', to be used again.
 
 ENTRY: 'n' indexes the individual.
        'tli' contains the time of last immigration.
@@ -1600,27 +1766,20 @@ ENTRY: 'n' indexes the individual.
        'immig[y]' contains the total number of immigrants each year.
 
 EXIT: N[A[n].state] is decremented.
-      'n' is recycled such that the highest-numbered individual within the
-       same region of birth as 'n' takes the index number 'n' and array 'A'
-       remains continuous.
+      'n' is released, and the last individual of the same region of birth
+       takes its place (see 'Vacate').
 
 */
 
 Emigrate(int n)
-{ int n2;
-
+{
 //-printf("Starting Emigration routine...\n"); fflush(stdout);
 
   N[A[n].state] -= 1;                        //Decrement N[A[n].state].
-
-  if(A[n].rob)                               //Use emigrant's region of birth
-  { n2 = ukbid-1; ukbid--; }                 //to find highest index number of
-                                             //individual who will take over
-  else                                       //emigrant's index number, to
-  { n2 = immid-1; immid--; }                 //prevent array from having gaps
-                                             //of unoccupied index numbers.
-//-printf("About to call Transfer() from Emigrate(), n=%d n2=%d\n", n,n2);
-  Transfer(n, n2);
+  if(pidx) Unlist(n);
+  if(A[n].lazy) Undefer(n);
+  if(pmut && A[n].state>=qI1) Mutations(n, t);
+  Vacate(n);                                 //Release the index number.
 }
 
 
@@ -1634,8 +1793,8 @@ uses a pseudo-individual (index number 'IMM') to schedule the external event.
 ENTRY: 't' contains the current time.
        't0' contains the end time of model.
        'pimm' contains the proportion of immigrants who are non-UK born.
-       'immid' contains the next available index number for non-UK born.
-       'ukbid' contains the next available index number for UK born.
+       'immid' contains the next available place for non-UK born.
+       'ukbid' contains the next available place for UK born.
        'IMM' contains the index number for the pseudo-individual used to
         schedule external immigration events handled here.
        'ypi' contains the years per immigration, re-calculated each year
@@ -1652,14 +1811,15 @@ ImmigrateG()
 //-printf("Starting ImmigrateG()....\n"); fflush(stdout);
   y = (int)(t-t0);                           //Get integer year array index.
 
-  if(Rand()<pimm[y]) { n = immid; immid++; } //Determine whether immigrant will
-  else               { n = ukbid; ukbid++; } //be UK or non-UK born.
+  if(Rand()<pimm[y]) n = PLACE(immid++);    //Determine whether immigrant will
+  else               n = PLACE(ukbid++);    //be UK or non-UK born.
 
   Immigrate(n);                              //Create immigrant.
 
   A[IMM].pending = pImmig;                   //Schedule next immigration.
 //-printf("About to schedule external immigration from ImmigrateG()\n");
   EventSchedule(IMM, t+ypi);
+  if(immid>maximm||ukbid>indiv) Grow();      //Make room for the next.
 }
 
 
@@ -1671,7 +1831,7 @@ This routine initiates a birth and schedules the next birth, at regularly spaced
 intervals, acting as the peripheral event generator for births.
 
 ENTRY: 't' contains the current time.
-       'ukbid' contains the next available ID number for UK-born.
+       'ukbid' contains the next available place for UK-born.
        'A[BIRTH]' is the individual designated for scheduling births.
        'ypb' contains years per birth.
 
@@ -1685,10 +1845,11 @@ BirthG()
 //-printf("Starting BirthG()....\n"); fflush(stdout);
 //-note Could check if t==t0 and not birth someone upon initialization at t0.
 //-Produces one extra birth at initialization
-  Birth(ukbid,t); ukbid += 1;            //Produce a birth and increment the next available index number for UK-born.
+  Birth(PLACE(ukbid),t); ukbid += 1;     //Produce a birth and increment the next available index number for UK-born.
   A[BIRTH].pending = pBirth;             //Schedule the next birth for 'ypb'
 //-printf("About to schedule external birth from BirthG()\n"); fflush(stdout);
   EventSchedule(BIRTH,t+ypb);            //years into the future.
+  if(immid>maximm||ukbid>indiv) Grow();  //Make room for the next.
 }
 
 
@@ -1719,7 +1880,12 @@ NewState(int n, int q)
 {
 //-printf("Starting NewState()...\n"); fflush(stdout);
   if(q>qU)                            //Reduce the number in the old state
-    N[A[n].state] -= 1;               //unless individual is entering Uninfected, which only happens at birth or immigration.
+  { N[A[n].state] -= 1;               //unless individual is entering Uninfected, which only happens at birth or immigration.
+    if(pidx) Unlist(n);
+    if(A[n].lazy) Undefer(n);         //(This change supersedes any deferred.)
+    if(pmut && A[n].state>=qI1)       //Count the mutations in the old state.
+      Mutations(n, t); }
+  else A[n].lazy = 0;
 
   if(N[A[n].state]<0)                 //Make sure the state has not become
     Error2(609.0, "q=",(dec)q,        //negative.
@@ -1732,6 +1898,9 @@ NewState(int n, int q)
 //-  else A[n].bstate |= 1<<(q-5);    //individual has visited.
 //-*/
   N[A[n].state] += 1;                 //Increase the number in the new state.
+  if(pidx) Enlist(n);
+  if(pmut && q>=qI1)                  //Count mutations in the new state
+    MARK(n) = TPUT(t);                //from now.
 }
 
 
@@ -1740,8 +1909,8 @@ NewState(int n, int q)
 TRANSFER
 
 This routine transfer all information about an individual (including saved event
-times) to a new identification number. The routine then cancels the pending
-event for that index number and re-schedules it using the new index number.
+times) to a new identification number. The routine then moves the pending event
+for that index number to the new index number, in place in the event queue.
 
 ENTRY: 'n' is the new index number to be assigned, which has no event scheduled
        'n2' is the current index number of the individual.
@@ -1757,11 +1926,697 @@ Transfer(int n, int n2)
 {
 //-printf("Starting Transfer()...\n"); fflush(stdout);
   if(n!=n2)
-  { A[n] = A[n2]; EventRenumber(n, n2); }    //Copy data and reschedule as 'n'.
+  { A[n] = A[n2]; Ac[n] = Ac[n2];            //Copy data and reschedule as 'n'.
+    EventRenumber(n, n2);
+    if(pidx && A[n].state)                   //Renumber its entry in the list
+    { Ml[A[n].state][A[n].rob][Mx[n2]] = n;  //of its state.
+      Mx[n] = Mx[n2]; } }
+}
+
+
+
+/*----------------------------------------------------------------------------*
+RELEASE AN INDEX NUMBER
+
+An individual's index number is also the number of its events in the scheduler.
+When an individual leaves, by death or emigration, the last individual of the
+same part of the list ordinarily takes its number with 'Transfer', so that each
+part stays dense and an individual can be chosen at random by number. That
+costs a copy of the record and a renumbering in the scheduler for each leaving.
+
+When 'STABLE' is set, an individual's number instead never changes while it is
+present. The record of one leaving is simply marked vacant, and its number kept
+to be used again; nothing is copied and the scheduler is not involved. So that
+'Transmission' can still choose an individual at random, the individuals
+present in each part are listed densely in 'D', non-UK born in places 1 through
+'immid-1' and UK-born in places 'maximm+1' through 'ukbid-1', with the place of
+each recorded in 'Dx'. The individual leaving gives up its place to the last of
+its part, and its number goes into the place vacated at the end, to be taken by
+the next to arrive. Each part of 'D' thus always holds every number of its part
+of the list, those in use first. Places in 'D' match the numbers of the
+ordinary scheme exactly, so the two give identical results.
+
+'STABLE' is off by default, since the scattered records it reuses and the
+lookups in 'D' and 'Dx' cost more than the copy and renumbering it saves.
+
+ENTRY: 'n' indexes an individual who is leaving the population.
+       No event is scheduled for individual 'n'.
+
+EXIT:  The last individual of the same part of the list has taken number 'n'
+         with its events, or if 'STABLE', 'A[n].state' is zero, marking the
+         record vacant, the last individual of the same part of 'D' has taken
+         the place of 'n', and 'n' is the next number to be used in that part.
+       'immid' or 'ukbid' is decremented.
+*/
+
+Vacate(int n)
+{ int p, q, m;
+
+  q = A[n].rob? --ukbid: --immid;            //Find the last place of the part.
+  if(!STABLE)                                //Ordinarily, move the individual
+  { Transfer(n, q); return; }                //there to number 'n'.
+
+  p = Dx[n];                                 //Otherwise, move the last
+  m = D[q];                                  //individual into the place being
+  D[p] = m; Dx[m] = p;                       //released, and the number being
+  D[q] = n; Dx[n] = q;                       //released into the last place.
+  A[n].state = 0;                            //Mark the record vacant.
+}
+
+
+
+/*----------------------------------------------------------------------------*
+LIST THE INDIVIDUALS IN EACH STATE
+
+'N' holds only the number of individuals in each state; anything finer, such as
+the number in a state born in the UK, or an individual drawn at random from a
+state, would otherwise need a scan of the whole list of individuals. With
+'pidx=1' the individuals in each state are also listed, separately by region of
+birth, in 'Ml[q][r]', which holds 'Mn[q][r]' of them, and the place of each in
+its list is held in 'Mx'. 'NewState' takes an individual from the list of its
+old state with 'Unlist' and adds it to that of its new state with 'Enlist', and
+'Death' and 'Emigrate' take it out of its list; the last of the list takes the
+place of one taken out, so each list stays dense. 'Transfer' and 'Reorder'
+renumber the entries with the individuals. The number in any state and region
+of birth is then simply 'Mn[q][r]', and 'Member' draws one of them at random,
+each in constant time. 'Report' checks the lists against 'N'.
+
+Each list grows as needed. Together they take one number for each individual
+present, and 'Mx' one for each in the list of individuals.
+
+ENTRY: 'n' indexes an individual whose state and region of birth are in 'A[n]'.
+         For 'Enlist', it is in no list; for 'Unlist', it is in the list of its
+         state.
+       'q' contains a state and 'r' a region of birth, 0 or 1.
+
+EXIT:  'n' has been added to or taken out of the list of its state.
+       'Member' contains an individual in state 'q' with region of birth 'r',
+         chosen at random, or 0 if there are none.
+*/
+
+Enlist(int n)
+{ int q, r;
+
+  q = A[n].state; r = A[n].rob;
+  if(Mn[q][r]==Mc[q][r])                     //Enlarge the list if it is full.
+  { Mc[q][r] = Mc[q][r]*2+1024;
+    Ml[q][r] = (int*)realloc(Ml[q][r], Mc[q][r]*sizeof(int));
+    if(Ml[q][r]==0) Error(911.); }
+
+  Mx[n] = Mn[q][r];                          //Add the individual at the end.
+  Ml[q][r][Mn[q][r]++] = n;
+}
+
+Unlist(int n)
+{ int q, r, m;
+
+  q = A[n].state; r = A[n].rob;
+  m = Ml[q][r][--Mn[q][r]];                  //Move the last individual of the
+  Ml[q][r][Mx[n]] = m; Mx[m] = Mx[n];        //list into this one's place.
+}
+
+int Member(int q, int r)
+{
+  if(Mn[q][r]==0) return 0;
+  return Ml[q][r][(int)(Rand()*Mn[q][r])];
+}
+
+
+
+/*----------------------------------------------------------------------------*
+DEFER A CHANGE OF STATE
+
+An effective vaccination takes an Uninfected individual to Immune at a time
+known when the individual enters the population, and a recent infection or
+reinfection becomes remote 'LAT' years after it was acquired. Each changes only
+the state, yet each was an event to be scheduled and dispatched, a sixth of all
+the events of a run. With 'plazy=1' neither is scheduled. 'Defer' records the
+time in 'Ac[n].tExit', marks the individual with 'A[n].lazy', and adds the time
+and the old state to the cell of 'Lv' holding that part of the year. The
+individual keeps its old state until something next touches it: 'Settle',
+called before any event of the individual is processed and by 'Infect', makes
+the change if it is due, and 'NewState', 'Death', and 'Emigrate' take out with
+'Undefer' a change superseded before it was due, such as a vaccination by an
+infection. Nothing else looks at the state of an individual.
+
+'N' is only reported, so it need only be right when 'Report' shows it.
+'Catchup' counts in 'N' every change in the cells due by then and takes it out
+of its cell, and 'lzt' holds the time to which that has been done, so 'Settle'
+changes the state of an individual whose change has been counted without
+counting it again. The cells hold no index numbers, which 'Transfer' and
+'Reorder' would otherwise have to follow. The lists of 'pidx' follow the state
+held in each record, not 'N', so the two options are not combined.
+
+'Latent' arranges the move to remote infection. Rather than at the time of the
+move, the time to reactivation disease that 'Remote' would draw then is drawn
+at once, for the individual's age at that time, and the earliest event after
+the move is scheduled in place of the move itself.
+
+ENTRY: 'n' indexes an individual present.
+       'w' contains the time of the change. For 'Defer', the new state is
+         Immune if the individual is now Uninfected, and otherwise Remote
+         Infection.
+       'wr' and 'wm' contain the times of the move to remote infection and of
+         strain mutation, and 'r' is set if an event is still scheduled for the
+         individual, as in 'Infect'.
+       For 'Catchup', 'w' contains the time of a report.
+
+EXIT:  'Defer' has deferred the change. 'Undefer' has cancelled it, and
+         'Settle' has made it if it is due.
+       'Latent' has deferred the move, recorded the time to disease in
+         'Ac[n].tDisease', and scheduled the earliest event after it, and
+         contains a status code as for 'Remote'.
+       'Catchup' has counted in 'N' every deferred change due by 'w'.
+*/
+
+Defer(int n, dec w)
+{ struct Lzc *c;
+
+  Ac[n].tExit = TPUT(w);                     //Record the time, as held, and
+  w = TGET(Ac[n].tExit);                     //mark the individual.
+  A[n].lazy = 1;
+  if(w>t1) return;                           //(Never due within the run.)
+
+  c = &Lv[(int)((w-t0)*LZC)];                //Add it to its cell, enlarging
+  if(c->n==c->c)                             //the cell if it is full.
+  { c->c = c->c*2+16;
+    c->v = (struct Lzy*)realloc(c->v, c->c*sizeof(struct Lzy));
+    if(c->v==0) Error(911.); }
+  c->v[c->n].w   = w;
+  c->v[c->n++].q = A[n].state;
+}
+
+Undefer(int n)
+{ int i; dec w; struct Lzc *c;
+
+  A[n].lazy = 0;
+  w = TGET(Ac[n].tExit);
+  if(w>t1) return;
+
+  c = &Lv[(int)((w-t0)*LZC)];                //Find the change in its cell and
+  for(i=0; i<c->n; i++)                      //put the last of the cell in its
+    if(c->v[i].w==w && c->v[i].q==A[n].state)     //place.
+    { c->v[i] = c->v[--c->n]; return; }
+  Error2(624., "n=",n, " w=",w);
+}
+
+Settle(int n)
+{ int q; dec w;
+
+  w = TGET(Ac[n].tExit);
+  if(w>t) return;                            //Leave a change not yet due.
+
+  q = A[n].state==qU? qV: qI2;               //Make the change, counting it
+  if(w>lzt) { NewState(n, q); return; }      //unless it has been counted.
+  A[n].state = q; A[n].lazy = 0;
+}
+
+Catchup(dec w)
+{ int k, k1, i, q; struct Lzc *c;
+
+  if(w<=lzt) return;
+  k1 = min(lzn-1, (int)((w-t0)*LZC));        //Pass through the cells from the
+  for(k=(int)((lzt-t0)*LZC); k<=k1; k++)     //last report, counting each
+  for(c=&Lv[k], i=0; i<c->n; )               //change due and taking it out.
+  { if(c->v[i].w>w) { i++; continue; }
+    q = c->v[i].q;
+    N[q] -= 1; N[q==qU? qV: qI2] += 1;
+    c->v[i] = c->v[--c->n]; }
+  lzt = w;
+}
+
+int Latent(int n, dec wr, dec wm, int r)
+{ int s, rob, k; dec w, wdis, wd, we;
+
+  Defer(n, wr);                              //Defer the move.
+
+  s   = A[n].sex;                            //Draw the time to disease from
+  rob = A[n].rob;                            //remote infection as 'Tdis'
+  if(SSAV && A[n].ssa==2) rob = 2;           //would at the time of the move.
+  wdis = wr+RandF(A2,d2[s][rob],AC+2,wr-TGET(A[n].tBirth));
+  Ac[n].tDisease = TPUT(wdis);
+  PUTM(n, wm);
+  wd = TGET(A[n].tDeath);
+  we = TGET(A[n].tEmigrate);
+
+  if(wd<wdis && wd<wm && wd<we)              //Find the earliest event as
+  { A[n].pending = pDeath;    w = wd;   k = 3; }  //'Remote' would.
+  else if(wm<wdis && wm<we)
+  { A[n].pending = pMutate;   w = wm;   k = 4; }
+  else if(we<wdis)
+  { A[n].pending = pEmigrate; w = we;   k = 5; }
+  else
+  { A[n].pending = pDisease;  w = wdis; k = 2; }
+
+  if(r) EventReschedule(n, w);               //Schedule it.
+  else  EventSchedule(n, w);
+  return k;
+}
+
+
+
+/*----------------------------------------------------------------------------*
+COUNT STRAIN MUTATIONS
+
+Strain mutation is a Poisson process while an individual is infected or
+diseased, at rate 'mi' or 'md' according to the state, and 'Mutate' does no
+more than add one to 'stid' before scheduling the next event again. With
+'pmut=1' no mutation is scheduled. Instead 'NewState' marks the time an
+individual enters an infected or diseased state, and when it leaves the state
+by any route, or when the run ends, the number of mutations since the mark is
+drawn from the Poisson distribution of that mean. The mark is held in a time of
+the record that the state does not use, 'Ac[n].tRep' while infected and
+'Ac[n].tDisease' while diseased (see 'MARK'), so the record is no larger.
+Mutations after the end of the run are not counted, as they would not have been
+dispatched.
+
+ENTRY: 'n' indexes an infected or diseased individual, with the time from
+         which its mutations are still to be counted in 'MARK(n)'.
+       'w' contains the time to count them to, normally the current time.
+       't1' contains the ending time.
+
+EXIT:  'stid' has been increased by the mutations counted, and the mark moved
+         to 'w'. 'Strains' has counted them for every such individual present.
+*/
+
+Mutations(int n, dec w)
+{ dec m;
+
+  w = min(w, t1);
+  m = w-TGET(MARK(n));                       //Draw the number in the time
+  if(m>0)                                    //since the mark.
+    stid += Poisson((A[n].state<=qI3? mi: md)*m);
+  MARK(n) = TPUT(w);
+}
+
+Strains()
+{ int n;
+
+  for(n=1; n<=IMEND; n++)                    //Count the mutations of each
+    if(A[n].state>=qI1) Mutations(n, t1);    //individual infected or diseased
+  for(n=maximm+1; n<=UKEND; n++)             //at the end of the run.
+    if(A[n].state>=qI1) Mutations(n, t1);
+}
+
+
+
+/*----------------------------------------------------------------------------*
+MAP MEMORY IN HUGE PAGES
+
+Dispatching reaches the list of individuals at random, so with ordinary 4 KB
+pages nearly every event misses in the processor's table of address
+translations as well as in the cache. With huge pages one entry of that table
+covers 2 MB or 1 GB of the list. This routine maps memory for a list in the
+largest pages the system will give: explicit huge pages of 1 GB (for a list at
+least that large) or 2 MB, which must have been set aside by the administrator
+(for example in '/proc/sys/vm/nr_hugepages'), or failing those, ordinary pages
+which the system is asked to gather into transparent huge pages as it can.
+
+ENTRY: 'k' is 0 for the main part of the list or 1 for the supplementary part.
+       'm' contains the number of bytes wanted.
+
+EXIT:  'Pages' points to the memory, cleared.
+       'hugek[k]' records the kind of page obtained and 'hugem[k]' the number
+         of bytes mapped, 'm' rounded up to a whole page.
+*/
+
+static int    hugek[2];                      //Kind of page for each list.
+static size_t hugem[2];                      //Bytes mapped for each list.
+static char  *hugen[] =                      //Names of the kinds of page.
+{ "4 KB", "transparent 2 MB", "2 MB", "1 GB" };
+
+static void *Pages(int k, size_t m)
+{ void *p; size_t g;
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+  for(hugek[k]=3; hugek[k]>=2; hugek[k]--)   //Try for explicit huge pages,
+  { g = hugek[k]==3? 1<<30: 1<<21;           //1 GB only if the list is as
+    if(m<g && hugek[k]==3) continue;         //large as that.
+    hugem[k] = (m+g-1) & ~(g-1);
+    p = mmap(0, hugem[k], PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|
+      MAP_HUGETLB|(hugek[k]==3? 30: 21)<<MAP_HUGE_SHIFT, -1, 0);
+    if(p!=MAP_FAILED) return p; }
+#endif
+
+  hugek[k] = 0; hugem[k] = m;                //Otherwise map ordinary pages
+  p = mmap(0, m, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if(p==MAP_FAILED) Error(911.);             //and ask for them to be made
+#ifdef MADV_HUGEPAGE                         //huge.
+  if(madvise(p, m, MADV_HUGEPAGE)==0) hugek[k] = 1;
+#endif
+  return p;
+}
+
+
+
+/*----------------------------------------------------------------------------*
+ALLOCATE SPACE FOR A LIST
+
+This routine provides the memory for either part of the list of individuals,
+allocating, enlarging, or releasing it. Ordinarily the memory is taken from the
+system. If 'pmap' is set, it is instead a file mapped into memory, extended
+with zeros as the list grows and mapped anew, so that the system can page the
+list to and from the file (see the beginning of this program). If 'phuge' is
+set, it is memory mapped in huge pages (see 'Pages'), and moved to a new mapping
+when the list grows.
+
+ENTRY: 'p' points to the list, or is zero if it is not yet allocated.
+       'k' is 0 for the main part, 'A', or 1 for the supplementary part, 'Ac'.
+       'm0' contains the number of bytes in the list, zero if it is new.
+       'm1' contains the number of bytes wanted, more than 'm0', or zero if the
+         list is to be released.
+
+EXIT:  'Space' points to the list, with 'm1' bytes of which the new ones are
+         cleared, or is zero if the list has been released.
+*/
+
+static int   mapfd[2] = { -1, -1 };          //Files holding the mapped lists.
+static char *mapfn[2] = { "popa.map", "popc.map" };
+
+#define ADVISE(h) madvise(A, (size_t)(indiv+3)*sizeof(struct Indiv), h)
+
+void *Space(void *p, int k, size_t m0, size_t m1)
+{ void *q; size_t h;
+
+  if(pmap==0 && phuge==0)                    //If the list is in memory,
+  { if(m1==0) { free(p); return 0; }         //release it, or allocate or
+    p = p? realloc(p, m1): calloc(m1, 1);    //enlarge it and clear the new
+    if(p==0) Error(911.);                    //part.
+    if(m0) memset((char*)p+m0, 0, m1-m0);
+    return p; }
+
+  if(pmap==0)                                //If it is in huge pages, map new
+  { h = hugem[k]; q = m1? Pages(k, m1): 0;   //memory, cleared, copy the list
+    if(p) { if(q) memcpy(q, p, m0);          //into it, and release the old.
+            munmap(p, h); }
+    return q; }
+
+  if(p) munmap(p, m0);                       //Otherwise unmap the file and
+  if(m1==0)                                  //close it if it is finished.
+  { close(mapfd[k]); mapfd[k] = -1; return 0; }
+
+  if(mapfd[k]<0)                             //Create the file if necessary,
+  { mapfd[k] = open(mapfn[k], O_RDWR|O_CREAT|O_TRUNC, 0600);
+    if(mapfd[k]<0) Error1(510., mapfn[k],0);
+    unlink(mapfn[k]); }
+  if(ftruncate(mapfd[k], m1))                //extend it with zeros, and map
+    Error1(512., mapfn[k],0);                //it again.
+  p = mmap(0, m1, PROT_READ|PROT_WRITE, MAP_SHARED, mapfd[k], 0);
+  if(p==MAP_FAILED) Error1(519., mapfn[k],0);
+  madvise(p, m1, MADV_RANDOM);               //Events reach it at random.
+  return p;
 }
 
 
 
+/*----------------------------------------------------------------------------*
+MEASURE RESIDENCY
+
+ENTRY: 'p' points to a list of 'm' bytes.
+
+EXIT:  'Resident' contains the percentage of the pages of the list that are
+         resident in memory.
+*/
+
+dec Resident(void *p, size_t m)
+{ size_t ps, a, i, n, r; unsigned char *v;
+
+  ps = sysconf(_SC_PAGESIZE);                //Find the pages spanned by the
+  a  = (size_t)p & ~(ps-1);                  //list.
+  n  = ((size_t)p+m-a+ps-1)/ps;
+
+  v = (unsigned char*)malloc(n); if(v==0) Error(911.);
+  if(mincore((void*)a, n*ps, v)) { free(v); return 0; }
+  for(r=i=0; i<n; i++) r += v[i]&1;          //Count those resident.
+  free(v);
+  return 100.*r/n;
+}
+
+
+
+/*----------------------------------------------------------------------------*
+SIZE THE LIST OF INDIVIDUALS
+
+This routine sets the size of the list of individuals from the data of the run,
+rather than from a fixed maximum, so that a small run uses only what it needs
+and a large one needs no recompiling. Each part of the list is made large
+enough for its part of the initial population plus all the births and
+immigrants projected through the end of the run, as if no one died or left,
+with a little to spare. It therefore ordinarily never fills; if it does, it is
+enlarged by 'Grow'.
+
+ENTRY: 'n1981', 'bcy', 'immig', and 'pimm' have been read and adjusted for the
+         parameters of the run.
+       No events have been scheduled.
+
+EXIT:  'maximm' contains the highest index number for non-UK born.
+       'indiv' contains the highest index number for any individual.
+       'A' and 'Ac' are allocated for 'indiv+3' individuals and cleared.
+       If 'STABLE', 'D' and 'Dx' list every number in its own place.
+       If 'pidx', 'Mx' is allocated for 'indiv+3' individuals.
+       If 'plazy', the cells of deferred changes of state are allocated.
+       The scheduler provides for events numbered through 'IMM'.
+*/
+
+#define CAPX 1.02                            //Proportion to spare.
+
+Capacity()
+{ int a, s, y, n; dec ni, nu;
+
+  ni = nu = 0;                               //Count the initial population
+  for(a=0; a<121; a++)                       //born outside and inside the UK,
+  for(s=0; s<2;   s++)                       //as 'InitPop' will create it.
+  { ni += ceil(n1981[a][s][NUK]);
+    nu += ceil(n1981[a][s][UK]); }
+
+  for(y=0; y<RT; y++)                        //Add the immigrants and births
+  { ni += immig[y]*pimm[y];                  //projected for each year.
+    nu += immig[y]*(1-pimm[y]) + bcy[y]; }
+
+  maximm = ni*CAPX + 1024;                   //Set the size of each part and
+  indiv  = maximm + nu*CAPX + 1024;          //allocate the list.
+
+  A  = (struct Indiv *) Space(0,  0, 0,      //(Not static because of gcc bug
+         (size_t)(indiv+3)*sizeof(struct Indiv));  //restricting such arrays
+  Ac = (struct Indivc *)Space(0,  1, 0,      //to 2GB.)
+         (size_t)(indiv+3)*sizeof(struct Indivc));
+  if(STABLE)                                 //List every number in its own
+  { D  = (int*)malloc((indiv+3)*sizeof(int));//place, none in use.
+    Dx = (int*)malloc((indiv+3)*sizeof(int));
+    if(D==0||Dx==0) Error(911.);
+    for(n=0; n<indiv+3; n++) D[n] = Dx[n] = n; }
+  if(pidx)                                   //Provide for the place of each
+  { Mx = (int*)malloc((indiv+3)*sizeof(int));//in the list of its state.
+    if(Mx==0) Error(911.); }
+  if(plazy)                                  //Provide the cells of deferred
+  { if(pidx) Error2(525., "plazy=",plazy, " pidx=",pidx);  //changes of state.
+    lzn = (int)((t1-t0)*LZC)+1; lzt = t0;
+    Lv = (struct Lzc*)calloc(lzn, sizeof(struct Lzc));
+    if(Lv==0) Error(911.); }
+  EventSize(IMM);                            //Have the scheduler match it.
+}
+
+
+
+/*----------------------------------------------------------------------------*
+ENLARGE THE LIST OF INDIVIDUALS
+
+This routine makes room for more non-UK born or UK-born individuals when the
+next place in 'D' of either would fall outside its part of the list. The list
+is reallocated larger, the generators of births and immigrants are moved to its
+new end, and if the non-UK born need room, the UK-born are moved up to make it,
+renumbered with 'Transfer' so the events go with the individuals. If 'STABLE',
+the new numbers of each part are listed in 'D' in places of their own.
+
+ENTRY: 'immid' exceeds 'maximm', or 'ukbid' exceeds 'indiv', or both.
+       Every individual in the list has an event scheduled, and so does each
+         generator whose 'pending' is set.
+
+EXIT:  'maximm', 'indiv', and 'ukbid' are increased as necessary and 'A',
+         'Ac', and if 'STABLE', 'D' and 'Dx', and if 'pidx', 'Mx' reallocated,
+         with the new entries of the list cleared.
+       'BIRTH' and 'IMM' index the generators at the new end of the list.
+*/
+
+Grow()
+{ int n, d, e, i0, u;
+
+  d = immid>maximm? maximm/4+1024: 0;        //Enlarge the full part or parts
+  e = ukbid>indiv? (indiv-maximm)/4+1024: 0; //by a quarter.
+  i0 = indiv; u = UKEND; indiv += d+e;
+
+  A  = (struct Indiv *) Space(A,  0,         //Reallocate the list, with the
+         (size_t)(i0+3)*sizeof(struct Indiv),     //new end cleared.
+         (size_t)(indiv+3)*sizeof(struct Indiv));
+  Ac = (struct Indivc *)Space(Ac, 1,
+         (size_t)(i0+3)*sizeof(struct Indivc),
+         (size_t)(indiv+3)*sizeof(struct Indivc));
+  if(STABLE)
+  { D  = (int*)realloc(D,  (indiv+3)*sizeof(int));
+    Dx = (int*)realloc(Dx, (indiv+3)*sizeof(int));
+    if(D==0||Dx==0) Error(911.);
+    for(n=i0+1; n<indiv+3; n++)              //List the new numbers in their
+      D[n] = Dx[n] = n; }                    //own places.
+  if(pidx)
+  { Mx = (int*)realloc(Mx, (indiv+3)*sizeof(int));
+    if(Mx==0) Error(911.); }
+  EventSize(IMM);
+
+  for(n=i0+2; n>i0; n--)                     //Move each generator to the new
+  { if(A[n].pending) Transfer(n+d+e, n);     //end, with its event if it has
+    else { A[n+d+e] = A[n]; Ac[n+d+e] = Ac[n]; } //one, and clear its old place.
+    memset(&A[n], 0, sizeof(struct Indiv)); }
+
+  if(d)                                      //Move the UK-born up, highest
+  { for(n=u; n>maximm; n--)                  //first, to make room for the
+    { if(A[n].state) Transfer(n+d, n);       //non-UK born, with their places
+      else { A[n+d] = A[n]; Ac[n+d] = Ac[n]; }    //in 'D' if 'STABLE'.
+      if(STABLE) D[n+d] = D[n]+d; }
+    if(STABLE)                               //List the numbers freed for the
+    { for(n=maximm+1; n<=maximm+d; n++)      //non-UK born in their own places.
+      { memset(&A[n], 0, sizeof(struct Indiv));
+        D[n] = n; }
+      for(n=maximm+1; n<=indiv; n++) Dx[D[n]] = n; }
+    maximm += d; ukbid += d; }
+}
+
+
+
+/*----------------------------------------------------------------------------*
+REORDER THE LIST OF INDIVIDUALS
+
+'Death' and 'Emigrate' keep each part of the list dense by moving its last
+individual into the place vacated (see 'Vacate'), so as the run goes on an
+individual's index comes to bear no relation to anything, and the records
+reached by successive events lie scattered over the whole list. This routine
+renumbers the individuals of each part so that records reached together lie
+together, any vacant records last. With
+'preord=1' they are put in order of their pending events, so that the events
+dispatched in the months that follow reach a narrow band of the list, and of
+the scheduler's own arrays, rather than all of it. With 'preord=2' they are
+put in order of year of birth, so that the census in 'Report' passes over long
+runs of the same age class. It is done every 'rgap' years, from 'Report'.
+
+The order need not be exact to bring records together, so individuals are
+counted into slots, of 1/'OS' year ahead of the present for pending events
+(all those beyond 'rgap' years sharing the last) or of one year of birth, and
+keep their existing order within each slot. The work is then proportional to
+the size of the list. The scheduler renumbers the events in a single pass with
+'EventPermute'.
+
+Contacts in 'Transmission' are chosen by index, so a run with reordering takes
+a different path from one without, with the same distributions of results. If
+'STABLE', they are chosen by place in 'D', which is left as it was, and the
+results are not changed.
+
+ENTRY: 'preord' is 1 or 2.
+       Every individual in the list has an event scheduled.
+
+EXIT:  The individuals of each part of the list have been renumbered, and their
+         events, entries in 'D' and 'Dx' if 'STABLE', and entries in the lists
+         of each state if 'pidx', with them.
+*/
+
+#define OS 64                                //Slots per year ahead.
+#define OB 1850                              //Earliest year of birth slotted.
+
+static dec ordn, ords;                       //Reorderings and seconds taken.
+static dec ordt;                             //Time of the last reordering.
+
+static int Order(int n0, int m)
+{ int i, k, q, r, ns, *v, *cnt; dec *w; void *x;
+
+  if(m<2) return 0;
+  ns = preord==1? OS*rgap+2: T1-OB+1;        //Allocate the new numbers, the
+  v   = (int*)malloc(m*sizeof(int));         //count for each slot, and the
+  cnt = (int*)calloc(ns+1, sizeof(int));     //times of pending events.
+  w   = preord==1? (dec*)malloc(m*sizeof(dec)): 0;
+  if(v==0 || cnt==0 || (preord==1 && w==0)) Error(911.);
+
+  if(w) EventTimes(w, n0, m);                //Find each individual's slot and
+  for(i=0; i<m; i++)                         //count the individuals in each.
+  { if(A[n0+i].state==0) k = ns-1;
+    else if(w) k = w[i]-t<rgap? (int)((w[i]-t)*OS): ns-1;
+    else  k = (int)floor(TGET(A[n0+i].tBirth))-OB;
+    k = k<0? 0: k>=ns? ns-1: k;
+    v[i] = k; cnt[k+1] += 1; }
+
+  for(k=1; k<=ns; k++) cnt[k] += cnt[k-1];   //Convert the counts to starting
+  for(i=0; i<m; i++)                         //places and give each individual
+    v[i] = n0 + cnt[v[i]]++;                 //the next in its slot.
+  EventPermute(v, n0, m);                    //Renumber the events.
+
+  x = malloc(m*max(sizeof(struct Indiv), sizeof(struct Indivc)));
+  if(x==0) Error(911.);                      //Move each record to its new
+  for(i=0; i<m; i++)                         //place in a work area and back,
+    ((struct Indiv*)x)[v[i]-n0] = A[n0+i];   //one part at a time.
+  memcpy(A+n0, x, m*sizeof(struct Indiv));
+  for(i=0; i<m; i++)
+    ((struct Indivc*)x)[v[i]-n0] = Ac[n0+i];
+  memcpy(Ac+n0, x, m*sizeof(struct Indivc));
+
+  if(STABLE)                                 //Renumber the individuals listed
+  for(i=n0; i<n0+m; i++)                     //in the same part of 'D'.
+  { D[i] = v[D[i]-n0]; Dx[D[i]] = i; }
+
+  if(pidx)                                   //And those in the list of each
+  for(q=q0; q<=q1; q++)                      //state.
+  for(r=0; r<2; r++)
+  for(i=0; i<Mn[q][r]; i++)
+  { k = Ml[q][r][i];
+    if(k>=n0 && k<n0+m) { Ml[q][r][i] = k = v[k-n0]; Mx[k] = i; } }
+
+  free(v); free(cnt); free(w); free(x);
+  return 0;
+}
+
+/*
+'Order' reorders the 'm' numbers from 'n0', which make up one part of the list;
+'Reorder' does both parts.
+*/
+
+Reorder()
+{ clock_t c;
+
+  if(preord<1||preord>2||rgap<0)             //Check the parameters.
+    Error2(525., "preord=",preord, " rgap=",rgap);
+
+  c = clock();                               //Reorder each part of the list,
+  Order(1, IMEND);                           //timing the work.
+  Order(maximm+1, UKEND-maximm);
+  ordn += 1; ords += (dec)(clock()-c)/CLOCKS_PER_SEC;
+  ordt = t;
+}
+
+
+
+#ifdef COMPACT
+/*----------------------------------------------------------------------------*
+CONVERT TIME FOR A RECORD
+
+When records are compact, this routine converts a time to be stored in a record
+to ticks (see 'common.h').
+
+ENTRY: 'y' contains the time, in years.
+       'up' is nonzero to round up to the next tick, zero to round down.
+
+EXIT:  'Tick' contains the time in ticks after 'TB', rounded as directed and
+         held within the range of a tick.
+*/
+
+tick Tick(dec y, int up)
+{ dec k;
+
+  k = (y-TB)/TU;                             //Convert to ticks and round.
+  k = up? ceil(k): floor(k);
+  if(k<0) return 0;                          //Hold the time within range.
+  if(k>4294967295.) return 4294967295U;
+  return (tick)k;
+}
+#endif
+
+
+
 /*----------------------------------------------------------------------------*
 ADD CUMULATIVE CASE
 
@@ -1811,8 +2666,9 @@ without tImm & tInfected & strain of model: */
 ADD REPORTED CASE
 
 This routine keeps track of the number of reported cases by age, sex, place of
-birth, disease site and calendar year. After a case is reported, they are
-scheduled for their next event.
+birth, disease site and calendar year (see 'Book'). After a case is reported,
+they are scheduled for their next event. With 'erep' set no report is scheduled
+and this routine is not used.
 
 ENTRY: 'n' is the new index number to be assigned.
        't' is the time the individual is added to the array.
@@ -1826,8 +2682,8 @@ ENTRY: 'n' is the new index number to be assigned.
        'repc' holds the numbers of reported cases.
        'A[n].tDeath contains the individual's time of death.
        'A[n].tEmigrate' contains the individual's time of emigration.
-       'A[n].tExit' contains the individual's time to remote infection.
-       'A[n].tMutate' contains the individual's strain mutation time.
+       'Ac[n].tExit' contains the individual's time to remote infection.
+       'Ac[n].tMutate' contains the individual's strain mutation time.
        'A[n].ssa' holds country of birth in SSA version of model,
         0=UK & non-UK other, 1=SSA, 2=SSA,HIV+
        'A[n].tImm' contains the time of immigration to UK.
@@ -1848,50 +2704,36 @@ EXIT:  'n' is the new index number of the individual.
 
 Rep(int n)
 {
-  int s,r,y,acl,d; dec age,wt, wd, we, wr, wm, wrep;
+  dec wt, wd, we, wr, wm;
 
 //-printf("Starting Rep() routine...\n"); fflush(stdout);
 //-/*
 //-  fprintf(rc, "%f\t%d\t%f\t%f\t%f\t%f\t%d\t%d\t%d\t%d\t%d\n",
-//-  t, n, t-A[n].tBirth, t-A[n].tDisease, A[n].tImm, A[n].tInfected,
+//-  t, n, t-A[n].tBirth, t-Ac[n].tDisease, A[n].tImm, A[n].tInfected,
 //-  A[n].strain, A[n].state, A[n].sex,   A[n].rob, A[n].inf);
 //-*/
 //-/*
 //-//w/o tImm & tInfected & strain:
 //-fprintf(rc, "%f\t%d\t%f\t%f\t%d\t%d\t%d\n",
-//-  t, n, t-A[n].tBirth, t-A[n].tDisease,
+//-  t, n, t-A[n].tBirth, t-Ac[n].tDisease,
 //-  A[n].state, A[n].sex,   A[n].rob);
 //-*/
 //-
 //****More efficient reporting for E&W version of model****//
-  age = t-A[n].tBirth;                       //Get age.
-  if(age<15) acl=0;                          //Find age class (classes which match
-  else if(age<45) acl=1;                     //notification rates).
-  else if(age<65) acl=2;
-  else acl=3;
-  s = A[n].sex;                              //Get sex.
-  r = A[n].rob;                              //Get region of birth, 0=non-UK, 1=UK.
-  if(SSAV)                                    //If running 'SSA' version of model
-    if(A[n].ssa)                             //check for ssa and change 'rob'
-      r = 2;                                 //to '2' if SubSah African.
-  y = (int)t - (int)t0;                      //Get year for array index.
-  if(A[n].state>=qD4) d=0;                   //Get disease site (pulm/non-pulm)
-  else d=1;                                  //for arrray index.
-  repc[acl][s][r][d][y] += 1;                //Increment cases in appropriate
-                                             //compartment.
-  A[n].tRep = t1*2+Rand();                   //Set reporting time to time beyond
+  Book(n, t);                                //Count the case.
+  Ac[n].tRep = TPUT(t1*2+Rand());            //Set reporting time to time beyond
                                              //model run time so it cannot be
                                              //scheduled again, in another routine.
-//-printf("Rescheduled reporting time (future) is: %f\n",A[n].tRep);
-//-printf("A[n].tRep = %f\n",A[n].tRep); fflush(stdout);
+//-printf("Rescheduled reporting time (future) is: %f\n",Ac[n].tRep);
+//-printf("Ac[n].tRep = %f\n",Ac[n].tRep); fflush(stdout);
 
-  wd = A[n].tDeath;                          //Get time of death.
-  we = A[n].tEmigrate;                       //Get time of emigration.
-  wr = A[n].tExit;                           //Get time to remote infection.
-  wm = A[n].tMutate;                         //Get strain mutation time.
+  wd = TGET(A[n].tDeath);                    //Get time of death.
+  we = TGET(A[n].tEmigrate);                 //Get time of emigration.
+  wr = TGET(Ac[n].tExit);                    //Get time to remote infection.
+  wm = GETM(n);                              //Get strain mutation time.
 
   if(A[n].state<qD4)                         //If this is pulmonary disease,
-  { wt = A[n].tTransm;                       //get time for transmission
+  { wt = GETT(n);                            //get time for transmission
     if(wt<wd && wt<we && wt<wr && wt<wm)     //and if it occurs before recovery,
     { A[n].pending = pTransm;                //mutation, emigration, and death,
 //-printf("About to schedule transm from Rep()\n"); fflush(stdout);
@@ -1925,6 +2767,46 @@ Rep(int n)
 
 
 
+/*----------------------------------------------------------------------------*
+COUNT A REPORTED CASE
+
+This routine adds a reported case to 'repc', in the class of the individual's
+age, sex, region of birth, and disease site at the time of the report. It is
+called by 'Rep' when the report is dispatched, or with 'erep=1' by 'Disease'
+when the disease starts, since the time of the report is known then and nothing
+that would change the class can happen before it (see 'Disease').
+
+ENTRY: 'n' indexes a diseased individual whose case is reported.
+       'w' contains the time of the report.
+       'A[n].tBirth' contains the time of birth.
+       'A[n].sex', 'A[n].rob', 'A[n].ssa', and 'A[n].state' contain the sex,
+         region of birth, country of birth in the SSA version, and disease
+         state.
+
+EXIT:  The case has been added to 'repc'.
+*/
+
+Book(int n, dec w)
+{ int s,r,y,acl,d; dec age;
+
+  age = w-TGET(A[n].tBirth);                 //Get age.
+  if(age<15) acl=0;                          //Find age class (classes which match
+  else if(age<45) acl=1;                     //notification rates).
+  else if(age<65) acl=2;
+  else acl=3;
+  s = A[n].sex;                              //Get sex.
+  r = A[n].rob;                              //Get region of birth, 0=non-UK, 1=UK.
+  if(SSAV)                                    //If running 'SSA' version of model
+    if(A[n].ssa)                             //check for ssa and change 'rob'
+      r = 2;                                 //to '2' if SubSah African.
+  y = (int)w - (int)t0;                      //Get year for array index.
+  if(A[n].state>=qD4) d=0;                   //Get disease site (pulm/non-pulm)
+  else d=1;                                  //for arrray index.
+  repc[acl][s][r][d][y] += 1;                //Increment cases in appropriate
+}                                            //compartment.
+
+
+
 /*----------------------------------------------------------------------------*
 LIFESPAN DISTRIBUTION
 
@@ -2139,7 +3021,7 @@ dec Tdis(int n, int a, int s, int rob, dec tinf)
         return w; } }                  //from relative risk over five years.
 
     case qI2:                          //Process Remote Infection.
-    { age = t-A[n].tBirth;
+    { age = t-TGET(A[n].tBirth);
       w = RandF(A2,d2[s][rob],AC+2,age);
 //-printf("Time until react disease is %f years, s=%d, rob=%d, age=%f\n",w,s,rob,age);
       return w;      }
@@ -2242,7 +3124,7 @@ Init()
   t                //Time of report.
   n                //Index number for individual
   t-A[n].tBirth    //Age
-  t-A[n].tDisease  //Disease duration
+  t-Ac[n].tDisease //Disease duration
   A[n].tImm        //Time of immigration to UK.
   A[n].tInfected   //Time individual was infected.
   A[n].strain      //Strain type identification number
@@ -2386,7 +3268,9 @@ Data()
       d2p[a][s][UK] = duk2p[1][s];
       d3p[a][s][UK] = duk3p[1][s]; } }
 
-  #define RSCALE (SUPER? "r|": "r|=n/5")     //Scaling factor 1/5 for laptops.
+  #ifndef RSCALE                             //Scaling factor 1/5 for laptops,
+  #define RSCALE (SUPER? "r|": "r|=n/5")     //unless set when compiling.
+  #endif
   FileIO("births.txt",   fmt[0],  RSCALE);   //Read birth data.
   FileIO("immigs.txt",   fmt[1],  RSCALE);   //Read immigration data.
   FileIO("pimm.txt",     fmt[2],  "r|");     //Read immigrants non-UK born.
@@ -2658,6 +3542,12 @@ ENTRY: 'n1981' contains numbers by age, sex, and rob for individuals in the
        'ssa1981' contains the proportion of SSAs among non-UK born
          at population initialization.
 
+Each individual is first scheduled for a basic event which is then often
+cancelled or changed when the disease state is assigned. The scheduler is
+therefore asked to hold all events until the population is complete, so that
+only the final event of each individual is placed in the queue, and all of them
+at once (see 'EventLoad' in 'schedule.c').
+
 EXIT:  The intial population is set up; each individual is assigned attributes
         and scheduled for exactly one event (other event times may be stored
         for an individual.
@@ -2667,6 +3557,7 @@ InitPop()
 { int a,s,i,n,st,rob; dec age,wd,we,wv,tinf;
   ukbid = maximm+1;                          //Initialize ID numbers to
   immid = 1;                                 //correct values.
+  EventLoad(1);                              //Hold events until complete.
 
 //-printf("About to start InitPop() with calls to RandF()\n");
 /* NOTE : Could make function so that UK-born, non-UK born and SSA-born are
@@ -2676,9 +3567,9 @@ states are assigned and processed in a function */
   for(a=0; a<121; a++)                       //First, initialize UK-born
   for(s=0; s<2;   s++)                       //(rob=1) population for all age
   for(i=0; i<n1981[a][s][UK]; i++)            //and sex categories.
-  { n = ukbid; ukbid++;                      //Take the next available ID.
+  { n = PLACE(ukbid++);                      //Take the next available ID.
     age = a+Rand();                          //Assign age plus random bit.
-    A[n].tBirth = t-age;                     //Assign birth time from age.
+    A[n].tBirth = TPUTB(t-age);              //Assign birth time from age.
     A[n].sex = s;                            //Assign sex.
     A[n].rob = rob = UK;                     //Set to UK-born.
 
@@ -2690,9 +3581,9 @@ states are assigned and processed in a function */
     for(a=0; a<121; a++)                     //version of model, taking into
     for(s=0; s<2;   s++)                     //account the proportion of
     for(i=0; i<n1981[a][s][NUK]; i++)        //SSAs and their HIV
-    { n = immid; immid++;                    //status.
+    { n = PLACE(immid++);                    //status.
       age = a+Rand();
-      A[n].tBirth = t-age;
+      A[n].tBirth = TPUTB(t-age);
       A[n].sex = s;
       A[n].rob = rob = NUK;
       if(Rand()<ssa1981[a][s])               //If SubSaharan African, indicate
@@ -2708,15 +3599,17 @@ states are assigned and processed in a function */
     for(a=0; a<121; a++)                     //version of model.
     for(s=0; s<2; s++)
     for(i=0; i<n1981[a][s][NUK]; i++)
-    { n=immid; immid++;
+    { n = PLACE(immid++);
       age=a+Rand();
-      A[n].tBirth = t-age;
+      A[n].tBirth = TPUTB(t-age);
       A[n].sex = s;
       A[n].rob = rob = NUK;
 
       BasicInd(n,NUK,age,s);                  //Set up basic individual.
       DisState(n,NUK,a); }                    //Assign disease state and
                                              //process accordingly.
+
+  EventLoad(0);                              //Load all events into the queue.
 }
 
 
@@ -2745,26 +3638,28 @@ BasicInd (int n, int rob, dec age, int s)
 { dec wd, we, wv;
 
   NewState(n,qU);                               //Assign to Uninfected state.
-  A[n].tDeath = wd = t+LifeDsn(s,age,m1[0][0]); //Assign time of death.
-  if(wd<A[n].tBirth+age) Error(612.2);          //Check death time.
+  A[n].tDeath = TPUT(wd = t+LifeDsn(s,age,m1[0][0])); //Assign time of death.
+  if(wd<TGET(A[n].tBirth)+age) Error(612.2);    //Check death time.
 //- A[n].tEmigrate = we = t+Expon(em[s][1]);   //Assign time of emigration (old).
-  A[n].tEmigrate = we                           //Assign time of emigration.
-                 = t+EmDsn(rob,s,age,em[s][rob]);
+  A[n].tEmigrate = TPUT(we                      //Assign time of emigration.
+                 = t+EmDsn(rob,s,age,em[s][rob]));
   if(age<v3[rob] && Rand()<v1[rob]*v2[rob])     //Calculate time to vaccination,
     wv = t+(v3[rob]-age)+Rand();                //set to time which never
   else wv = t+2*RT+Rand();                      //happens if it should not occur.
 
-  if(wv<wd && wv<we)                            //If vaccination is the earliest
-  { A[n].pending = pVaccin;                     //event, schedule it.
-    EventSchedule(n, wv); }
-
+  if(wv<wd && wv<we && !plazy)                  //If vaccination is the earliest
+  { A[n].pending = pVaccin;                     //event, schedule it (with
+    EventSchedule(n, wv); }                     //'plazy' it is deferred instead,
+                                                //and 'tExit' holds its time).
   else if(wd<we)                                //If death is the earliest
-  { A[n].tExit = wd;                            //event, schedule it.
+  { if(wv<wd) Defer(n, wv);                     //event, schedule it.
+    else Ac[n].tExit = TPUT(wd);
     A[n].pending = pDeath;
 //-printf("About to schedule death from InitPop()\n"); fflush(stdout);
     EventSchedule(n, wd); }
   else                                          //Or, if emigration is the
-  { A[n].tExit = we;                            //earliest event, schedule that.
+  { if(wv<we) Defer(n, wv);                     //earliest event, schedule that.
+    else Ac[n].tExit = TPUT(we);
     A[n].pending = pEmigrate;
 //-printf("About to schedule emig from InitPop()\n"); fflush(stdout);
     EventSchedule(n, we); }
@@ -2875,6 +3770,8 @@ ENTRY: 'prog' contains the name of the program presently running.
        'kernel' defines the contagion kernel.
        'deaths' and 'events' contain the number of deaths and events since
          the counters were cleared.
+       The event scheduler has kept its running statistics since the previous
+         report.
        //-'relativetime' is set if the simulated times are to be reported relative
        //- to the simulated starting time.
        'rand0' defines the random number sequence used.
@@ -2884,11 +3781,17 @@ EXIT:  The next line of the report has been printed.
 */
 
 static int ReportFirst;
-ReportInit() { ReportFirst = 0; }
+static dec censn, censs;                     //Censuses taken and seconds taken.
+
+ReportInit()
+{
+  ReportFirst = 0; censn = censs = 0;
+  ordn = ords = 0; ordt = -1e300;
+}
 
 Report(char *prog)
 {
-  int i, ac,r,y,yr; dec z,age;
+  int i, ac,r,y,yr; dec z,age,qs[6]; clock_t c;
 
 //-printf("Starting Report() function \n");
   if(ReportFirst==0)
@@ -2931,6 +3834,12 @@ Report(char *prog)
     printf("Label Deaths:  Number of deaths since last report.\n");
     printf("Label Events:  Number of events dispatched since last report.\n");
     printf("Label Elapsed: Seconds of elapsed wall-clock time to this point.\n");
+    printf("Label Sorts:   Number of scheduler bins sorted since last report.\n");
+    printf("Label Slen:    Mean number of events in each bin sorted.\n");
+    printf("Label Finds:   Number of events searched for in their bins.\n");
+    printf("Label Flen:    Mean number of steps in each search.\n");
+    printf("Label Empty:   Number of empty scheduler bins passed over.\n");
+    printf("Label Cycles:  Number of cycles through all scheduler bins.\n");
 
     printf("\n|t     |N       |Up      |Vp      "
                     "|I1      |I2      |I3      "
@@ -2940,12 +3849,15 @@ Report(char *prog)
                     "|I1      |I2      |I3      "
                     "|D1      |D2      |D3      "
                     "|D4      |D5      |D6      "
-                    "|Deaths  |Events  |Elapsed \n");
+                    "|Deaths  |Events  |Elapsed "
+                    "|Sorts   |Slen    |Finds   |Flen    |Empty   |Cycles  \n");
   }
 
+  if(plazy) Catchup(min(t,t1));              //Count deferred changes due.
   for(z=0,i=q0; i<=q1; i++) z += N[i];       //Get population size.
+  EventStats(qs);                            //Get scheduler statistics.
 
-  printf("|%6.1f|%8.0f|%f|%f|%f|%f|%f|%f|%f|%f|%f|%f|%f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8d|%8d|%5d\n",
+  printf("|%6.1f|%8.0f|%f|%f|%f|%f|%f|%f|%f|%f|%f|%f|%f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8.0f|%8d|%8d|%8d|%8.0f|%8.3f|%8.0f|%8.3f|%8.0f|%8.0f\n",
     t, z,
     N[qU]/z, N[qV]/z, N[qI1]/z, N[qI2]/z, N[qI3]/z,
                       N[qD1]/z, N[qD2]/z, N[qD3]/z,
@@ -2954,12 +3866,21 @@ Report(char *prog)
                       N[qI1],   N[qI2],   N[qI3],
                       N[qD1],   N[qD2],   N[qD3],
                       N[qD4],   N[qD5],   N[qD6],
-                      deaths, events, (int)(time(NULL)-startsec));
+                      deaths, events, (int)(time(NULL)-startsec),
+                      qs[0], qs[1], qs[2], qs[3], qs[4], qs[5]);
 
   fprintf(stderr, "  %.1f\r", t);            //Update status indicator.
   fflush(stdout); fflush(stderr);            //Make sure everything shows.
   deaths = events = 0;                       //Clear time-step counters.
 
+  if(preord && t<t1 && t-ordt>=rgap)         //Reorder the list of individuals
+    Reorder();                               //periodically if requested.
+
+  if(pidx)                                   //Make sure the lists of the
+  for(i=q0; i<=q1; i++)                      //individuals in each state hold
+    if(Mn[i][0]+Mn[i][1]!=N[i])              //all of them.
+      Error2(623., "q=",i, " N=",N[i]);
+
   y = (int)t;                                //Get calendar (integer) year.
 
   if(y>lup)                                  //Check to see if parameters
@@ -2972,21 +3893,26 @@ Report(char *prog)
                                              //necessary (mid-year).
 
     yr = y-(int)t0;                          //Get year array index.
-    for(i=1; i<immid; i++)                   //Loop through immigrants.
-    {
+    c = clock();                             //Time the census.
+    if(pmap) ADVISE(MADV_SEQUENTIAL);        //(The list is read in order.)
+    for(i=1; i<=IMEND; i++)                  //Loop through immigrants,
+    { if(A[i].state==0) continue;            //passing over vacant records.
       r=0;                                   //If running SSA version of
       if(SSAV && A[i].ssa) r=2;               //model, find out if SSA.
 
-      age = t-A[i].tBirth;                   //Get age and find age class.
+      age = t-TGET(A[i].tBirth);             //Get age and find age class.
       ac = age<15?0: age<45?1: age<65?2: 3;
       N2[ac][A[i].sex][r][yr] += 1; }        //Increment correct compartment
                                              //for this individual.
 
     r=1;                                     //Loop through UK-born.
-    for(i=maximm+1; i<ukbid; i++)
-    { age = t-A[i].tBirth;                   //Get age and find age class.
+    for(i=maximm+1; i<=UKEND; i++)
+    { if(A[i].state==0) continue;
+      age = t-TGET(A[i].tBirth);             //Get age and find age class.
       ac = age<15?0: age<45?1: age<65?2: 3;
       N2[ac][A[i].sex][r][yr] += 1; }
+    if(pmap) ADVISE(MADV_RANDOM);            //(Events resume at random.)
+    censn += 1; censs += (dec)(clock()-c)/CLOCKS_PER_SEC;
   }
 }
 
@@ -3035,6 +3961,8 @@ static dec tsmin  =  1E10;                   //Smallest time step
 static dec tsmax  = -1E10;                   //Largest time step
 
 static dec trho, nrho;                       //Statistics for local dispersal.
+static char *qn[] =                          //Names of the states.
+{ "", "U", "V", "I1", "I2", "I3", "D1", "D2", "D3", "D4", "D5", "D6" };
 static dec tinfections, linfections;
 
 
@@ -3048,12 +3976,18 @@ FinalInit()
 }
 
 Final()
-{ int a,s,r,y,d; dec size,w;
-  FILE *cases, *pop;
+{ int a,s,r,y,d; dec size,w; struct rusage ru; char line[256];
+  FILE *cases, *pop, *fp;
 
   printf("\n");
-  size  = (indiv+3) * sizeof(struct Indiv);
+  size  = (indiv+3) * (sizeof(struct Indiv)+sizeof(struct Indivc)
+        + (STABLE? 2*sizeof(int): 0) + (pidx? sizeof(int): 0));
+  for(y=q0; y<=q1; y++)                      //(Add the lists of individuals
+    size += (dec)(Mc[y][0]+Mc[y][1])*sizeof(int);  //in each state.)
+  for(y=0; y<lzn; y++)                       //(And the deferred changes of
+    size += (dec)Lv[y].c*sizeof(struct Lzy); //state.)
   size += EventProfile("Final");
+  EventTrace(0);                             //Close any scheduler trace.
 
   tstepfin();
   { printf("Time steps:      Mean %s, Min %s, Max %s, SD %s, N %.0f\n",
@@ -3065,6 +3999,8 @@ Final()
   { printf("Infections:      Targeted %.0f, out of area %.0f, ratio %.2f%%\n",
       tinfections, tinfections-linfections,
       100.*(tinfections-linfections)/tinfections); }
+  printf("Mutations:       %d new strain types%s\n", stid,
+    pmut? ", counted without events": "");
 
   if(agec[0])
   { age1[0] /= agec[0]; age2[0] = sqrt(age2[0]/agec[0] - age1[0]*age1[0]);
@@ -3079,6 +4015,33 @@ Final()
   printf("\n");
   printf("Memory usage:    %.2f gigabytes\n", size/(1024*1024*1024));
 
+  getrusage(RUSAGE_SELF, &ru);               //Report paging and how much of
+  printf("Page faults:     Major %ld, minor %ld\n",  //the list is in memory.
+    ru.ru_majflt, ru.ru_minflt);
+  printf("Resident:        Main part %.1f%%, supplementary part %.1f%%%s\n",
+    Resident(A,  (size_t)(indiv+3)*sizeof(struct Indiv)),
+    Resident(Ac, (size_t)(indiv+3)*sizeof(struct Indivc)),
+    pmap? ", mapped from files": "");
+  if(phuge && pmap==0)                       //Report the kind of page given
+    printf("Pages:           Main part %s, supplementary part %s\n",
+      hugen[hugek[0]], hugen[hugek[1]]);     //each part of the list, and how
+  if((fp=fopen("/proc/self/smaps_rollup", "r")))  //much memory is in
+  { for(w=0; fgets(line, sizeof line, fp); ) //transparent huge pages.
+      sscanf(line, "AnonHugePages: %lf", &w);
+    fclose(fp);
+    printf("Huge pages:      %.0f megabytes transparent\n", w/1024); }
+
+  if(censn)                                  //Report the time taken by the
+    printf("Census:          %.0f scans, %.1f ms each\n",  //census and by
+      censn, 1000*censs/censn);              //any reordering.
+  if(ordn)
+    printf("Reordering:      %.0f passes by %s, %.1f s each\n", ordn,
+      preord==1? "pending event": "year of birth", ords/ordn);
+  if(pidx)                                   //Display the number in each state,
+  { printf("States:          ");             //non-UK born and UK-born.
+    for(y=q0; y<=q1; y++)
+      printf("%s %d/%d%s", qn[y], Mn[y][0], Mn[y][1], y<q1? ", ": "\n"); }
+
   printf("Elapsed time:    %s\n",
     Tval((dec)(time(NULL)-startsec)/60/60/24/365.25));
 
@@ -3297,7 +4260,9 @@ char *pntab[] =                              //Table of parameter names.
   "r4[0]","r4[1]", "r5[0]", "r5[1]","r6[0]","r6[1]",
   "r7[0]","r7[1]", "r8[0]", "r8[1]", "df",
   "d1uk20", "d2uk20", "d3uk20",
-  "pmale[0]", "randseq", 0 };
+  "pmale[0]", "randseq", "qtype", "qtrace", "pmap", "phuge", "preord",
+  "rgap", "pidx", "erep", "plazy", "pmut",
+  0 };
 
 dec *patab[] =                               //Table of parameter addresses.
 { &s2[0], &s2[1], &c[0][0],&c[0][1],&c[1][0],&c[1][1],
@@ -3306,7 +4271,9 @@ dec *patab[] =                               //Table of parameter addresses.
   &r4[0], &r4[1], &r5[0], &r5[1], &r6[0], &r6[1],
   &r7[0], &r7[1], &r8[0], &r8[1], &df,
   &d1uk20[0], &d2uk20[0], &d3uk20[0],
-  &pmale[0], &randseq, 0 };
+  &pmale[0], &randseq, &qtype, &qtrace, &pmap, &phuge, &preord,
+  &rgap, &pidx, &erep, &plazy, &pmut,
+  0 };
 
 #include "service.c"
 
@@ -3317,7 +4284,7 @@ NOTES
 _____________________________________________________
 Before running on supercomputer:
 1) Change 'SUPER' to '1'
-2) In common.h change #define indiv to higher value
+   (The list of individuals is sized from the data; see 'Capacity'.)
 _____________________________________________________
 
 